@@ -0,0 +1,530 @@
+#include "core/ListingObject.hpp"
+#include "core/ObjectString.hpp"
+#include "core/LevelColors.hpp"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmarks for the headless core on generated levels and libraries.
+ *
+ * Usage: betterobjects-bench [filter] [max objects]
+ *
+ * Only benchmarks whose name contains `filter` are run. Every benchmark reports time per
+ * object (or per library node), allocations per object and the peak RSS of the process,
+ * so run a single benchmark when its peak RSS matters.
+ */
+
+namespace PMBenchmarks {
+	std::atomic<size_t> allocations = 0;
+	std::atomic<size_t> allocatedBytes = 0;
+
+	// keeps results alive so the measured work isn't optimized away
+	volatile size_t sink = 0;
+
+	// checks that went wrong, the bench exits with 1 if there are any
+	size_t failures = 0;
+}
+
+namespace PMBenchmarks {
+	// every replaced operator new below ends up here, so they are all counted the same way
+	[[gnu::noinline]] void *allocate(size_t size, size_t alignment) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		void *ptr;
+
+		if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			ptr = std::malloc(size ? size : 1);
+		} else {
+			// aligned_alloc wants a multiple of the alignment
+			ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+		}
+
+		if (ptr == nullptr) throw std::bad_alloc();
+
+		return ptr;
+	}
+
+	[[gnu::noinline]] void release(void *ptr) noexcept {
+		std::free(ptr);
+	}
+}
+
+void *operator new(size_t size) {
+	return PMBenchmarks::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new[](size_t size) {
+	return PMBenchmarks::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+	return PMBenchmarks::allocate(size, (size_t)alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+	return PMBenchmarks::allocate(size, (size_t)alignment);
+}
+
+void operator delete(void *ptr) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+	PMBenchmarks::release(ptr);
+}
+
+namespace PMBenchmarks {
+	std::string filter = "";
+	size_t maxObjects = 1000000;
+
+	size_t peakRSS() {
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+
+		// kilobytes on linux
+		return usage.ru_maxrss;
+	}
+
+	/**
+	 * Runs `body` once and prints its cost per unit.
+	 * `units` is the amount of objects (or nodes) the body goes through.
+	 */
+	template <typename F>
+	void run(const std::string &name, size_t units, F &&body) {
+		if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+		size_t allocations_start = allocations.load();
+		size_t bytes_start = allocatedBytes.load();
+
+		auto time_start = std::chrono::steady_clock::now();
+
+		body();
+
+		double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - time_start).count();
+
+		double count = std::max<size_t>(units, 1);
+
+		fmt::print("{:<40} {:>9} {:>12.2f} ms {:>12.1f} ns/obj {:>8.2f} allocs/obj {:>10.1f} B/obj {:>10.1f} MB peak\n",
+			name, units, elapsed / 1e6, elapsed / count,
+			(allocations.load() - allocations_start) / count,
+			(allocatedBytes.load() - bytes_start) / count,
+			peakRSS() / 1024.0
+		);
+	}
+
+	/**
+	 * Builds a level string of `count` objects that look like editor output:
+	 * blocks, decorations and triggers with rotations, groups and colors.
+	 */
+	std::string makeLevel(size_t count, uint32_t seed = 1) {
+		static const int object_ids[] = {1, 1, 1, 8, 7, 211, 1006, 899, 901, 1007, 1049, 1268, 1616};
+
+		std::mt19937 rng(seed);
+		std::string level;
+		level.reserve(count * 48);
+
+		for (size_t i = 0; i < count; i++) {
+			if (i != 0) level += ';';
+
+			int id = object_ids[rng() % std::size(object_ids)];
+
+			level += fmt::format("1,{},2,{},3,{}", id, (rng() % 4000) * 7.5f + 15, (rng() % 64) * 7.5f + 15);
+
+			if (rng() % 4 == 0) level += fmt::format(",6,{}", (int)(rng() % 4) * 90);
+			if (rng() % 3 == 0) level += fmt::format(",21,{}", 1000 + rng() % 12);
+			if (rng() % 2 == 0) level += fmt::format(",57,{}.{}", 1 + rng() % 999, 1 + rng() % 999);
+			if (id >= 899) level += fmt::format(",36,1,51,{},10,0.5", 1 + rng() % 999);
+			if (rng() % 8 == 0) level += ",155,1";
+		}
+
+		return level;
+	}
+
+	// level header with `count` start colors
+	std::string makeHeader(size_t count) {
+		std::string colors;
+
+		for (size_t i = 0; i < count; i++) {
+			if (i != 0) colors += '|';
+
+			colors += fmt::format("1_{}_2_{}_3_{}_11_255_12_255_13_255_4_-1_6_{}_7_1_15_1_18_0_8_1", i % 256, (i * 7) % 256, (i * 13) % 256, i + 1);
+		}
+
+		return fmt::format("kS38,{},kA13,0,kA15,0,kA16,0,kA14,,kA6,0,kA7,0", colors);
+	}
+
+	// every folder holds `width` collections of `objects` objects and one subfolder, down to `depth`
+	ListingObject makeLibrary(int depth, int width, size_t objects, size_t &nodes) {
+		ListingObject folder(ListingObject::Folder, 0, fmt::format("folder {}", depth));
+
+		folder._folderContainer.reserve(width + 1);
+
+		for (int i = 0; i < width; i++) {
+			ListingObject collection(ListingObject::ObjectCollection, 0, fmt::format("collection {}", i));
+			collection.setObjectContainer(makeLevel(objects, nodes + 1));
+
+			folder._folderContainer.push_back(std::move(collection));
+			nodes++;
+		}
+
+		if (depth > 0) {
+			folder._folderContainer.push_back(makeLibrary(depth - 1, width, objects, nodes));
+		}
+
+		nodes++;
+
+		return folder;
+	}
+
+	void levelBenchmarks(size_t count) {
+		std::string level = makeLevel(count);
+
+		std::vector<std::string> objects;
+
+		run("splitString", count, [&] {
+			objects = PMGlobal::splitString(level.c_str(), ';');
+		});
+
+		std::vector<PMGlobal::ObjectRecord> records;
+		records.reserve(objects.size());
+
+		run("parseObjectData", count, [&] {
+			for (const std::string &object : objects) {
+				records.push_back(PMGlobal::parseObjectData(object));
+			}
+		});
+
+		run("buildKVString", count, [&] {
+			size_t size = 0;
+
+			for (PMGlobal::ObjectRecord &record : records) {
+				size += PMGlobal::buildKVString(record).size();
+			}
+
+			sink = sink + size;
+		});
+
+		run("setPositionToString", count, [&] {
+			size_t size = 0;
+
+			for (const std::string &object : objects) {
+				size += PMGlobal::setPositionToString(object, {30.f, 90.f}).size();
+			}
+
+			sink = sink + size;
+		});
+
+		run("setPositionToString(record)", count, [&] {
+			size_t size = 0;
+
+			for (PMGlobal::ObjectRecord &record : records) {
+				size += PMGlobal::setPositionToString(record, {30.f, 90.f}).size();
+			}
+
+			sink = sink + size;
+		});
+
+		PMGlobal::CollectionTemplate collection;
+
+		run("CollectionTemplate", count, [&] {
+			collection = PMGlobal::CollectionTemplate(level);
+		});
+
+		run("CollectionTemplate::build", count, [&] {
+			std::string out;
+			collection.build({300.f, 90.f}, out);
+
+			sink = sink + out.size();
+		});
+
+		std::string compressed;
+
+		run("PayloadCodec::compress", count, [&] {
+			compressed = PayloadCodec::compress(level);
+		});
+
+		run("PayloadCodec::decompress", count, [&] {
+			std::string out;
+			PayloadCodec::decompress(compressed, out);
+
+			sink = sink + out.size();
+		});
+
+		if (!compressed.empty()) {
+			fmt::print("{:<40} {:>9} {:>12} bytes -> {} bytes\n", "", count, level.size(), compressed.size());
+		}
+	}
+
+	void fail(std::string_view check, size_t input) {
+		fmt::print(stderr, "FAILED: {} (input {})\n", check, input);
+
+		failures++;
+	}
+
+	/**
+	 * Round trips generated levels and random bytes through PayloadCodec, then feeds it
+	 * truncated and corrupted blocks, which have to be rejected or decoded without a crash.
+	 */
+	void codecChecks(size_t count) {
+		std::mt19937 rng(7);
+		std::vector<std::string> inputs = {"", "1", "1,1,2,15,3,15", PayloadCodec::dictionary().data()};
+
+		for (size_t size = 1; size <= count; size *= 10) {
+			inputs.push_back(makeLevel(size, size));
+		}
+		for (size_t i = 0; i < 64; i++) {
+			std::string bytes(rng() % 70000, '\0');
+
+			for (char &c : bytes) c = (char)(rng() % (i % 2 ? 256 : 4));
+
+			inputs.push_back(std::move(bytes));
+		}
+
+		run("PayloadCodec round trip", inputs.size(), [&] {
+			for (size_t i = 0; i < inputs.size(); i++) {
+				std::string compressed = PayloadCodec::compress(inputs[i]);
+				std::string out;
+
+				if (!PayloadCodec::decompress(compressed, out) || out != inputs[i]) fail("round trip", i);
+
+				for (size_t length = 0; length < compressed.size(); length += 1 + compressed.size() / 64) {
+					if (PayloadCodec::decompress(std::string_view(compressed).substr(0, length), out)) fail("truncated block accepted", i);
+				}
+
+				for (int flip = 0; flip < 64 && !compressed.empty(); flip++) {
+					std::string corrupted = compressed;
+					corrupted[rng() % corrupted.size()] ^= (char)(1 + rng() % 255);
+
+					PayloadCodec::decompress(corrupted, out);
+				}
+
+				sink = sink + out.size();
+			}
+		});
+	}
+
+	// how positions were moved before the numbers went through from_chars/to_chars
+	std::string legacyMoveObject(std::string_view object_string, cocos2d::CCPoint delta) {
+		std::string out;
+		PMGlobal::KVTokenizer tokenizer(object_string);
+
+		int key;
+		std::string_view value;
+
+		while (tokenizer.next(key, value)) {
+			if (!out.empty()) out += ',';
+
+			out += std::to_string(key);
+			out += ',';
+
+			if (key == 2) {
+				out += std::to_string(std::stof(std::string(value)) + delta.x);
+			} else if (key == 3) {
+				out += std::to_string(std::stof(std::string(value)) + delta.y);
+			} else {
+				out += value;
+			}
+		}
+
+		return out;
+	}
+
+	// rewrites positions of `count` objects, and reads and writes `count` floats, the old way and the new one
+	void numberBenchmarks(size_t count) {
+		std::vector<std::string> objects = PMGlobal::splitString(makeLevel(count).c_str(), ';');
+
+		run("move objects (stof/to_string)", count, [&] {
+			size_t size = 0;
+
+			for (const std::string &object : objects) {
+				size += legacyMoveObject(object, {30.f, 90.f}).size();
+			}
+
+			sink = sink + size;
+		});
+
+		run("move objects (appendMovedObject)", count, [&] {
+			size_t size = 0;
+			std::string out;
+
+			for (const std::string &object : objects) {
+				out.clear();
+				PMGlobal::appendMovedObject(out, object, {30.f, 90.f});
+
+				size += out.size();
+			}
+
+			sink = sink + size;
+		});
+
+		std::vector<std::string> values;
+		values.reserve(count);
+
+		for (size_t i = 0; i < count; i++) {
+			values.push_back(PMGlobal::formatFloat((i % 40000) * 7.5f / 8 - 1000.f));
+		}
+
+		run("read floats (std::stof)", count, [&] {
+			float sum = 0.f;
+
+			for (const std::string &value : values) {
+				sum += std::stof(value);
+			}
+
+			sink = sink + (size_t)sum;
+		});
+
+		run("read floats (toFloat)", count, [&] {
+			float sum = 0.f;
+
+			for (const std::string &value : values) {
+				sum += PMGlobal::toFloat(value);
+			}
+
+			sink = sink + (size_t)sum;
+		});
+
+		run("write floats (std::to_string)", count, [&] {
+			size_t size = 0;
+
+			for (size_t i = 0; i < count; i++) {
+				size += std::to_string(i * 0.75f).size();
+			}
+
+			sink = sink + size;
+		});
+
+		run("write floats (appendFloat)", count, [&] {
+			size_t size = 0;
+			std::string out;
+
+			for (size_t i = 0; i < count; i++) {
+				out.clear();
+				PMGlobal::appendFloat(out, i * 0.75f);
+
+				size += out.size();
+			}
+
+			sink = sink + size;
+		});
+	}
+
+	void colorBenchmarks(size_t count) {
+		std::string header = makeHeader(count);
+
+		run("LevelStartObject", count, [&] {
+			LevelStartObject start(header);
+
+			sink = sink + start.getColorObjects().size();
+		});
+
+		LevelStartObject start(header);
+
+		run("ColorObject::toTrigger", count, [&] {
+			size_t size = 0;
+
+			for (ColorObject &color : start.getColorObjects()) {
+				size += color.toTrigger({0.f, 0.f}).size();
+			}
+
+			sink = sink + size;
+		});
+	}
+
+	void libraryBenchmarks(const char *shape, int depth, int width) {
+		size_t nodes = 0;
+		ListingObject tree = makeLibrary(depth, width, 20, nodes);
+
+		std::string prefix = fmt::format("library {} {}x{}: ", shape, depth, width);
+		std::string text;
+
+		// compact, indentation would grow with depth and hide how parsing scales
+		run(prefix + "dump", nodes, [&] {
+			text = tree.toJson().dump();
+		});
+
+		run(prefix + "parse", nodes, [&] {
+			ListingObject parsed = text;
+
+			sink = sink + parsed._folderContainer.size();
+		});
+
+		run(prefix + "export", nodes, [&] {
+			std::ostringstream stream;
+			ListingObjectWriter writer(stream, false);
+
+			writer.begin();
+			writer.write(tree);
+			writer.end();
+
+			sink = sink + stream.tellp();
+		});
+
+		run(prefix + "copy", nodes, [&] {
+			ListingObject copy = tree;
+
+			sink = sink + copy._folderContainer.size();
+		});
+
+		run(prefix + "ListingExParams", nodes, [&] {
+			for (size_t i = 0; i < nodes; i++) {
+				ListingExParams params;
+				params._origScale = i;
+
+				std::string json = params;
+				ListingExParams parsed = json;
+
+				sink = sink + parsed._custom;
+			}
+		});
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1) PMBenchmarks::filter = argv[1];
+	if (argc > 2) PMBenchmarks::maxObjects = std::strtoull(argv[2], nullptr, 10);
+
+	for (size_t count = 1000; count <= PMBenchmarks::maxObjects; count *= 10) {
+		PMBenchmarks::levelBenchmarks(count);
+	}
+
+	PMBenchmarks::codecChecks(PMBenchmarks::maxObjects);
+
+	PMBenchmarks::numberBenchmarks(PMBenchmarks::maxObjects);
+
+	for (size_t count = 10; count <= std::min<size_t>(PMBenchmarks::maxObjects, 10000); count *= 10) {
+		PMBenchmarks::colorBenchmarks(count);
+	}
+
+	// same shapes as the old in-game benchmark, scaled up
+	for (int scale = 1; scale <= 8; scale *= 2) {
+		PMBenchmarks::libraryBenchmarks("deep", 64 * scale, 4);
+		PMBenchmarks::libraryBenchmarks("wide", 1, 2000 * scale);
+	}
+
+	return PMBenchmarks::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include "LevelColors.hpp"
+
+ColorObject::ColorObject(std::string_view v) {
+	PMLog::debug("ColorObject: v = {}", v);
+
+	PMGlobal::KVTokenizer tokenizer(v, '_');
+
+	int key;
+	std::string_view value;
+
+	// hue is considered enabled unless key 4 says otherwise
+	_hueEnabled = true;
+
+	while (tokenizer.next(key, value)) {
+		switch (key) {
+			case 1: _color.r = PMGlobal::toInt(value); break;
+			case 2: _color.g = PMGlobal::toInt(value); break;
+			case 3: _color.b = PMGlobal::toInt(value); break;
+			case 4: _hueEnabled = PMGlobal::toInt(value) != -1; break;
+			case 5: _blending = PMGlobal::toInt(value); break;
+			case 6: _target = PMGlobal::toInt(value); break;
+			case 7: _opacity = PMGlobal::toFloat(value); break;
+			case 8: _legacyHue = PMGlobal::toInt(value); break;
+			case 9: _copyTarget = PMGlobal::toInt(value); break;
+			case 10: _hsvObject = value; break;
+			case 11: _color2.r = PMGlobal::toInt(value); break;
+			case 12: _color2.g = PMGlobal::toInt(value); break;
+			case 13: _color2.b = PMGlobal::toInt(value); break;
+			case 15: _unk00 = PMGlobal::toInt(value); break;
+			case 17: _copyOpacity = PMGlobal::toInt(value); break;
+			case 18: _unk01 = PMGlobal::toInt(value); break;
+			default: break;
+		}
+	}
+}
+
+void ColorObject::debug() {
+	PMLog::debug("ColorObject::debug: hue enabled: {}; hsv: {}; id={};", hueEnabled(), _hsvObject, _target);
+}
+
+std::string ColorObject::toTrigger(cocos2d::CCPoint pos) {
+	using PMGlobal::appendFloat;
+	using PMGlobal::appendInt;
+
+	std::string str;
+	str.reserve(128);
+
+	str += "1,899,2,";
+	appendFloat(str, pos.x);
+	str += ",3,";
+	appendFloat(str, pos.y);
+	str += ",7,";
+	appendInt(str, _color.r);
+	str += ",8,";
+	appendInt(str, _color.g);
+	str += ",9,";
+	appendInt(str, _color.b);
+	str += ",10,0.1,17,";
+	appendInt(str, _blending);
+	str += ",23,";
+	appendInt(str, _target);
+	str += ",20,100,35,";
+	appendFloat(str, _opacity);
+
+	if (_hueEnabled || !_hsvObject.empty()) {
+		str += ",49,";
+		str += _hsvObject;
+		str += ",41,";
+		appendInt(str, _hueEnabled);
+	}
+
+	if (_copyTarget != 0) {
+		str += ",50,";
+		appendInt(str, _copyTarget);
+	}
+	if (_copyOpacity) {
+		str += ",60,1";
+	}
+
+	return str;
+}
+
+LevelStartObject::LevelStartObject(std::string_view v) {
+	std::string_view colors;
+
+	{
+		// level header starts with "kS38,<color list>,..."
+		PMGlobal::StringTokenizer header(v, ',');
+
+		if (!header.next(colors) || !header.next(colors)) return;
+	}
+
+	PMGlobal::StringTokenizer tokenizer(colors, '|');
+	std::string_view color;
+
+	while (tokenizer.next(color)) {
+		_colorObjects.emplace_back(color);
+	}
+}
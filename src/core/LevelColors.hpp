@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Platform.hpp"
+#include "ObjectString.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ColorObject {
+private:
+	std::string _hsvObject = "";
+
+	cocos2d::_ccColor3B _color = {};
+	cocos2d::_ccColor3B _color2 = {};
+	
+	bool _hueEnabled = false;
+	bool _blending = false;
+	bool _copyOpacity = false;
+	bool _legacyHue = false;
+
+	int _target = 0;
+	int _copyTarget = 0;
+	int _unk00 = 1;
+	int _unk01 = 0;
+
+	float _opacity = 1.f;
+
+	int getHueEnabled() {
+		if (_hueEnabled) return 1;
+
+		return -1;
+	}
+	bool hueEnabled() {
+		return _hueEnabled || !_hsvObject.empty();
+	}
+public:
+	ColorObject() {}
+
+	/**
+	 * key 1 - r
+	 * key 2 - g
+	 * key 3 - b
+	 * key 4 - hue enabled (-1 on disabled)
+	 * key 5 - blending
+	 * key 6 - color id
+	 * key 7 - opacity
+	 * key 8 - legacy hue enabled
+	 * key 9 - copied color id
+	 * key 10 - hue map (hue, sat, br, sat rel, br rel)
+	 * key 11 - ? (its always 255)
+	 * key 12 - ? (its always 255)
+	 * key 13 - ? (its always 255)
+	 * key 15 - ? (its always 1)
+	 * key 17 - copy opacity
+	 * key 18 - ? (its always 0) 
+	 */
+	ColorObject(std::string_view v);
+	ColorObject(const ColorObject &ref) {
+		_hsvObject = ref._hsvObject;
+		_color = ref._color;
+		_color2 = ref._color2;
+		_hueEnabled = ref._hueEnabled;
+		_blending = ref._blending;
+		_copyOpacity = ref._copyOpacity;
+		_legacyHue = ref._legacyHue;
+		_target = ref._target;
+		_copyTarget = ref._copyTarget;
+		_unk00 = ref._unk00;
+		_unk01 = ref._unk01;
+		_opacity = ref._opacity;
+	}
+
+	// operator std::string() {
+	// 	return fmt::format("1_{}_2_{}_3_{}_4_{}_5_{}_6_{}_7_{}_8_{}_9_{}_10_{}_11_{}_12_{}_13_{}_15_{}_17_{}_18_{}",
+	// 		_color.r, _color.g, _color.b, 
+	// 		getHueEnabled(),
+	// 		(int)_blending,
+	// 		_target,
+	// 		_opacity,
+	// 		(int)_legacyHue,
+	// 		_copyTarget,
+	// 		_hsvObject,
+	// 		_color2.r, _color2.g, _color2.b,
+	// 		_unk00,
+	// 		(int)_copyOpacity,
+	// 		_unk01
+	// 	);
+	// }
+
+	void debug();
+
+	std::string toTrigger(cocos2d::CCPoint pos);
+};
+
+class LevelStartObject {
+private:
+	std::vector<ColorObject> _colorObjects = {};
+public:
+	LevelStartObject(std::string_view v);
+
+	std::vector<ColorObject> &getColorObjects() {
+		return _colorObjects;
+	}
+};
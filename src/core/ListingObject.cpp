@@ -0,0 +1,516 @@
+#include "ListingObject.hpp"
+
+std::string_view PayloadCodec::dictionary() {
+	static const std::string dict =
+		"1,1,2,15,3,15;1,1,2,45,3,15;1,8,2,75,3,15;1,7,2,105,3,45;1,211,2,135,3,75,6,90;"
+		"1,899,2,165,3,105,36,1,7,255,8,255,9,255,10,0.5,35,1,23,1;"
+		"1,901,2,195,3,135,36,1,28,30,29,0,10,0.5,30,0,85,2,51,1;"
+		"1,1006,2,225,3,165,36,1,51,1,10,0.5,45,0.5,46,1,47,0.5;"
+		"1,1007,2,255,3,195,36,1,35,0,51,1,10,0.5;1,1049,2,285,3,225,36,1,51,1,56,1;"
+		"1,1268,2,315,3,255,36,1,51,1,63,0.5;1,1616,2,345,3,285,36,1,51,1;"
+		",4,1,5,1,6,90,6,-90,6,180,20,1,21,1004,22,1003,24,-1,25,9,32,0.5,32,2,57,1,57,1.2,64,1,67,1,108,1,128,0.5,129,0.5,155,1,";
+
+	return dict;
+}
+
+std::string PayloadCodec::compress(std::string_view input) {
+	std::string_view dict = dictionary();
+
+	// the dictionary is the history in front of the input
+	std::string window;
+	window.reserve(dict.size() + input.size());
+	window.append(dict);
+	window.append(input);
+
+	const char *base = window.data();
+	size_t start = dict.size();
+	size_t end = window.size();
+
+	// heads of hash chains, and the previous position with the same hash for every position
+	std::vector<uint32_t> table(1 << HASH_BITS, UINT32_MAX);
+	std::vector<uint32_t> chain(window.size(), UINT32_MAX);
+
+	auto insert = [&](size_t i) {
+		uint32_t h = hash4(base + i);
+
+		chain[i] = table[h];
+		table[h] = i;
+	};
+
+	for (size_t i = 0; i + MIN_MATCH <= start; i++) {
+		insert(i);
+	}
+
+	std::string out;
+	out.reserve(sizeof(uint32_t) + input.size() / 2 + 16);
+
+	appendLittleEndian<uint32_t>(out, input.size());
+
+	size_t anchor = start;
+	size_t pos = start;
+	size_t match_limit = end >= MATCH_SAFE_DISTANCE ? end - MATCH_SAFE_DISTANCE : 0;
+	size_t length_limit = end >= LAST_LITERALS ? end - LAST_LITERALS : 0;
+
+	while (pos < match_limit) {
+		size_t best_length = 0;
+		size_t best_candidate = 0;
+
+		uint32_t candidate = table[hash4(base + pos)];
+
+		for (int attempt = 0; attempt < MAX_ATTEMPTS && candidate != UINT32_MAX && pos - candidate <= MAX_OFFSET; attempt++) {
+			if (read32(base + candidate) == read32(base + pos)) {
+				size_t length = MIN_MATCH;
+
+				while (pos + length < length_limit && base[candidate + length] == base[pos + length]) {
+					length++;
+				}
+
+				if (length > best_length) {
+					best_length = length;
+					best_candidate = candidate;
+				}
+			}
+
+			candidate = chain[candidate];
+		}
+
+		insert(pos);
+
+		if (best_length == 0) {
+			pos++;
+
+			continue;
+		}
+
+		size_t literals = pos - anchor;
+		size_t match_extra = best_length - MIN_MATCH;
+
+		out += (char)((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(match_extra, 15));
+
+		if (literals >= 15) writeLength(out, literals - 15);
+
+		out.append(base + anchor, literals);
+
+		appendLittleEndian<uint16_t>(out, pos - best_candidate);
+
+		if (match_extra >= 15) writeLength(out, match_extra - 15);
+
+		for (size_t i = pos + 1; i < pos + best_length && i < match_limit; i++) {
+			insert(i);
+		}
+
+		pos += best_length;
+		anchor = pos;
+	}
+
+	size_t literals = end - anchor;
+
+	out += (char)(std::min<size_t>(literals, 15) << 4);
+
+	if (literals >= 15) writeLength(out, literals - 15);
+
+	out.append(base + anchor, literals);
+
+	return out;
+}
+
+bool PayloadCodec::decompress(std::string_view input, std::string &output) {
+	std::string_view dict = dictionary();
+
+	uint32_t raw_size;
+
+	if (input.size() < sizeof(raw_size)) return false;
+
+	raw_size = loadLittleEndian<uint32_t>(input.data());
+
+	std::string out;
+	out.reserve(dict.size() + raw_size);
+	out.append(dict);
+
+	size_t limit = dict.size() + raw_size;
+	size_t pos = sizeof(raw_size);
+
+	auto read_length = [&](size_t &length) {
+		uint8_t byte = 255;
+
+		while (byte == 255) {
+			if (pos >= input.size()) return false;
+
+			byte = input[pos++];
+			length += byte;
+		}
+
+		return true;
+	};
+
+	// a block always ends with a sequence of literals only
+	bool ended = false;
+
+	while (pos < input.size()) {
+		uint8_t token = input[pos++];
+		size_t literals = token >> 4;
+
+		if (literals == 15 && !read_length(literals)) return false;
+		if (input.size() - pos < literals || limit - out.size() < literals) return false;
+
+		out.append(input.data() + pos, literals);
+		pos += literals;
+
+		// the last sequence has no match
+		if (pos == input.size()) {
+			ended = true;
+
+			break;
+		}
+
+		uint16_t offset;
+
+		if (input.size() - pos < sizeof(offset)) return false;
+
+		offset = loadLittleEndian<uint16_t>(input.data() + pos);
+		pos += sizeof(offset);
+
+		size_t length = token & 15;
+
+		if (length == 15 && !read_length(length)) return false;
+
+		length += MIN_MATCH;
+
+		if (offset == 0 || offset > out.size() || limit - out.size() < length) return false;
+
+		// matches may overlap with their own output
+		size_t from = out.size() - offset;
+
+		for (size_t i = 0; i < length; i++) {
+			out += out[from + i];
+		}
+	}
+
+	if (!ended || out.size() != limit) return false;
+
+	output.assign(out, dict.size());
+
+	return true;
+}
+
+std::string PayloadCodec::toBase64(std::string_view data) {
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string out;
+	out.reserve((data.size() + 2) / 3 * 4);
+
+	for (size_t i = 0; i < data.size(); i += 3) {
+		uint32_t chunk = (uint8_t)data[i] << 16;
+
+		if (i + 1 < data.size()) chunk |= (uint8_t)data[i + 1] << 8;
+		if (i + 2 < data.size()) chunk |= (uint8_t)data[i + 2];
+
+		out += alphabet[(chunk >> 18) & 63];
+		out += alphabet[(chunk >> 12) & 63];
+		out += i + 1 < data.size() ? alphabet[(chunk >> 6) & 63] : '=';
+		out += i + 2 < data.size() ? alphabet[chunk & 63] : '=';
+	}
+
+	return out;
+}
+
+bool PayloadCodec::fromBase64(std::string_view data, std::string &output) {
+	if (data.size() % 4 != 0) return false;
+
+	auto value = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') return c - 'A';
+		if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+		if (c >= '0' && c <= '9') return c - '0' + 52;
+		if (c == '+') return 62;
+		if (c == '/') return 63;
+
+		return -1;
+	};
+
+	output.clear();
+	output.reserve(data.size() / 4 * 3);
+
+	for (size_t i = 0; i < data.size(); i += 4) {
+		int v[4];
+		int padding = 0;
+
+		for (int j = 0; j < 4; j++) {
+			char c = data[i + j];
+
+			if (c == '=' && i + 4 == data.size() && j >= 2) {
+				v[j] = 0;
+				padding++;
+			} else if (padding != 0 || (v[j] = value(c)) < 0) {
+				return false;
+			}
+		}
+
+		uint32_t chunk = (v[0] << 18) | (v[1] << 12) | (v[2] << 6) | v[3];
+
+		output += (char)(chunk >> 16);
+		if (padding < 2) output += (char)(chunk >> 8);
+		if (padding < 1) output += (char)chunk;
+	}
+
+	return true;
+}
+
+const std::vector<std::string> &ObjectLineTable::get() {
+	std::lock_guard lock(_mutex);
+
+	if (_loaded) return _lines;
+
+	_loaded = true;
+
+	std::string data(_length, '\0');
+
+	std::ifstream in(_filename, std::ios::binary);
+	in.seekg(_offset);
+	in.read(data.data(), _length);
+
+	// u32 count, then u32 length and the text of every line
+	size_t pos = 0;
+	auto read_u32 = [&](uint32_t &value) {
+		if (data.size() - pos < sizeof(value)) return false;
+
+		value = loadLittleEndian<uint32_t>(data.data() + pos);
+		pos += sizeof(value);
+
+		return true;
+	};
+
+	uint32_t count = 0;
+
+	if (!in.good() || !read_u32(count)) {
+		PMLog::error("ObjectLineTable::get: could not read {} bytes at {} from {}", _length, _offset, _filename);
+
+		return _lines;
+	}
+
+	// every line takes at least its length, a broken count must not reserve more than that
+	if (count > (data.size() - pos) / sizeof(uint32_t)) {
+		PMLog::error("ObjectLineTable::get: line table in {} is broken", _filename);
+
+		return _lines;
+	}
+
+	_lines.reserve(count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t length = 0;
+
+		if (!read_u32(length) || data.size() - pos < length) {
+			PMLog::error("ObjectLineTable::get: line table in {} is broken", _filename);
+
+			_lines.clear();
+
+			return _lines;
+		}
+
+		_lines.emplace_back(data, pos, length);
+		pos += length;
+	}
+
+	return _lines;
+}
+
+bool ObjectPayload::decode(const std::string &stored, std::string &data) const {
+	if (_location.encoding == Raw) {
+		data = stored;
+
+		return true;
+	}
+
+	if (_location.encoding == Compressed) {
+		return PayloadCodec::decompress(stored, data);
+	}
+
+	if (_location.encoding != ObjectLines || _location.lines == nullptr || stored.size() % sizeof(uint32_t) != 0) return false;
+
+	const std::vector<std::string> &lines = _location.lines->get();
+
+	for (size_t pos = 0; pos < stored.size(); pos += sizeof(uint32_t)) {
+		uint32_t id = loadLittleEndian<uint32_t>(stored.data() + pos);
+
+		if (id >= lines.size()) return false;
+
+		if (pos != 0) data += ';';
+		data += lines[id];
+	}
+
+	return true;
+}
+
+bool ObjectPayload::read(std::string &data) const {
+	if (_generation != currentGeneration) {
+		PMLog::warn("ObjectPayload::get: {} was rewritten, payload at {} is lost", _location.filename, _location.offset);
+
+		return false;
+	}
+
+	std::ifstream in(_location.filename, std::ios::binary);
+	in.seekg(_location.offset);
+
+	std::string stored(_location.length, '\0');
+	in.read(stored.data(), _location.length);
+
+	if (!in.good() || !decode(stored, data)) {
+		PMLog::error("ObjectPayload::get: could not read {} bytes at {} from {}", _location.length, _location.offset, _location.filename);
+
+		data.clear();
+
+		return false;
+	}
+
+	return true;
+}
+
+nlohmann::json ListingObject::toJson(bool compress) const {
+	nlohmann::json json;
+
+	json["type"] = (int)_type;
+	json["name"] = _name;
+
+	nlohmann::json folderContainer = nlohmann::json::array();
+
+	for (const ListingObject &entry : _folderContainer) {
+		folderContainer.push_back(entry.toJson(compress));
+	}
+
+	json["folderContainer"] = std::move(folderContainer);
+
+	visitObjectContainer([&](std::string_view objects) {
+		if (compress && !objects.empty()) {
+			json["objectContainer"] = "";
+			json["objectContainerLZ4"] = PayloadCodec::toBase64(PayloadCodec::compress(objects));
+		} else {
+			json["objectContainer"] = objects;
+		}
+	});
+
+	json["uid"] = getUniqueID();
+
+	return json;
+}
+
+void ListingObject::loadJson(const nlohmann::json &data) {
+	if (data.contains("type") && data["type"].is_number()) {
+		_type = (enum ListingObjectType)(data["type"].get<int>());
+	}
+	if (data.contains("name") && data["name"].is_string()) {
+		_name = data["name"].get<std::string>();
+	}
+	if (data.contains("objectContainer") && data["objectContainer"].is_string()) {
+		setObjectContainer(data["objectContainer"].get<std::string>());
+	}
+	if (data.contains("objectContainerLZ4") && data["objectContainerLZ4"].is_string()) {
+		setCompressedObjectContainer(data["objectContainerLZ4"].get<std::string>());
+	}
+	if (data.contains("folderContainer") && data["folderContainer"].is_array()) {
+		const nlohmann::json &folderContainer = data["folderContainer"];
+
+		_folderContainer.reserve(folderContainer.size());
+
+		for (const nlohmann::json &it : folderContainer) {
+			if (!it.is_object()) continue;
+
+			_folderContainer.emplace_back(ObjectCollection, -1, "");
+			_folderContainer.back().loadJson(it);
+		}
+	}
+
+	if (data.contains("uid") && data["uid"].is_number()) {
+		_uniqueID = data["uid"].get<UniqueID>();
+	} else {
+		setUniqueID();
+	}
+}
+
+void ListingObjectWriter::writeString(std::string_view value) {
+	_out.put('"');
+
+	size_t start = 0;
+
+	for (size_t i = 0; i < value.size(); i++) {
+		unsigned char c = value[i];
+		char escape[7] = {};
+
+		switch (c) {
+			case '"': std::strcpy(escape, "\\\""); break;
+			case '\\': std::strcpy(escape, "\\\\"); break;
+			case '\b': std::strcpy(escape, "\\b"); break;
+			case '\f': std::strcpy(escape, "\\f"); break;
+			case '\n': std::strcpy(escape, "\\n"); break;
+			case '\r': std::strcpy(escape, "\\r"); break;
+			case '\t': std::strcpy(escape, "\\t"); break;
+			default: {
+				if (c >= 0x20) continue;
+
+				static const char hex[] = "0123456789abcdef";
+
+				std::strcpy(escape, "\\u00");
+				escape[4] = hex[c >> 4];
+				escape[5] = hex[c & 15];
+			}
+		}
+
+		_out.write(value.data() + start, i - start);
+		_out << escape;
+
+		start = i + 1;
+	}
+
+	_out.write(value.data() + start, value.size() - start);
+	_out.put('"');
+}
+
+void ListingObjectWriter::writeObject(const ListingObject &object) {
+	_out.put('{');
+
+	writeKey("folderContainer");
+	_out.put('[');
+
+	bool first = true;
+
+	for (const ListingObject &entry : object._folderContainer) {
+		if (!first) _out.put(',');
+		first = false;
+
+		writeObject(entry);
+	}
+
+	_out << "],";
+
+	writeKey("name");
+	writeString(object._name);
+	_out.put(',');
+
+	writeKey("objectContainer");
+
+	if (object._objectPayload == nullptr) {
+		writeString("");
+	} else {
+		object._objectPayload->visit([&](std::string_view objects) {
+			if (_compress && !objects.empty()) {
+				writeString("");
+				_out.put(',');
+
+				writeKey("objectContainerLZ4");
+				writeString(PayloadCodec::toBase64(PayloadCodec::compress(objects)));
+			} else {
+				writeString(objects);
+			}
+		});
+	}
+
+	_out.put(',');
+
+	writeKey("type");
+	writeNumber(object._type);
+	_out.put(',');
+
+	writeKey("uid");
+	writeNumber(object.getUniqueID());
+
+	_out.put('}');
+}
@@ -0,0 +1,796 @@
+#pragma once
+
+#include "Platform.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// library files and compressed payloads store integers little endian on every platform
+template <typename T>
+void appendLittleEndian(std::string &out, T value) {
+	auto bits = (std::make_unsigned_t<T>)value;
+
+	for (size_t i = 0; i < sizeof(T); i++) {
+		out += (char)(uint8_t)(bits >> (i * 8));
+	}
+}
+
+template <typename T>
+T loadLittleEndian(const char *data) {
+	std::make_unsigned_t<T> bits = 0;
+
+	for (size_t i = 0; i < sizeof(T); i++) {
+		bits |= (std::make_unsigned_t<T>)(uint8_t)data[i] << (i * 8);
+	}
+
+	return (T)bits;
+}
+
+class ListingExParams {
+public:
+	bool _custom = false;
+	float _origScale = 1.f;
+
+	ListingExParams() {}
+
+	operator nlohmann::json() {
+		nlohmann::json json;
+
+		json["c"] = _custom;
+		json["o"] = _origScale;
+
+		return json;
+	}
+	operator std::string() {
+		nlohmann::json json = *this;
+
+		return json.dump();
+	}
+
+	ListingExParams(std::string &json_string) {
+		nlohmann::json json = nlohmann::json::parse(json_string);
+
+		_custom = json["c"].get<bool>();
+		_origScale = json["o"].get<double>();
+	}
+};
+
+/**
+ * LZ4 block format codec for object strings.
+ *
+ * Compressed payloads are stored as a u32 raw size followed by one LZ4 block.
+ * Matches may reach into a built-in dictionary of common GD key/value text,
+ * which helps small collections the most.
+ */
+class PayloadCodec {
+private:
+	static constexpr size_t MIN_MATCH = 4;
+	static constexpr size_t LAST_LITERALS = 5;
+	static constexpr size_t MATCH_SAFE_DISTANCE = 12;
+	static constexpr size_t MAX_OFFSET = 65535;
+	static constexpr int HASH_BITS = 16;
+	// candidates tried per position, more gives better ratios on long levels
+	static constexpr int MAX_ATTEMPTS = 16;
+
+	static uint32_t read32(const char *p) {
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+
+		return value;
+	}
+
+	static uint32_t hash4(const char *p) {
+		return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	static void writeLength(std::string &out, size_t length) {
+		while (length >= 255) {
+			out += (char)255;
+			length -= 255;
+		}
+
+		out += (char)length;
+	}
+public:
+	static std::string_view dictionary();
+
+	static std::string compress(std::string_view input);
+
+	// false if `input` is not a valid compressed payload
+	static bool decompress(std::string_view input, std::string &output);
+
+	static std::string toBase64(std::string_view data);
+
+	static bool fromBase64(std::string_view data, std::string &output);
+};
+
+/**
+ * Unique object lines of a library file, used by payloads stored as line references.
+ * The table is read from the file the first time such a payload is loaded.
+ */
+class ObjectLineTable {
+private:
+	std::mutex _mutex;
+
+	std::vector<std::string> _lines = {};
+	bool _loaded = false;
+
+	std::string _filename = "";
+	uint64_t _offset = 0;
+	uint64_t _length = 0;
+public:
+	ObjectLineTable(std::string filename, uint64_t offset, uint64_t length) : _filename(std::move(filename)), _offset(offset), _length(length) {}
+
+	// empty if the table could not be read
+	const std::vector<std::string> &get();
+};
+
+/**
+ * Object string of a collection.
+ *
+ * Payloads coming from the library file are only read from disk when they are needed.
+ * A payload never changes after creation, so copies of a ListingObject share it.
+ */
+class ObjectPayload {
+public:
+	enum Encoding : uint8_t {
+		// the object string as is
+		Raw = 0,
+		// u32 indices into the line table of the file, joined with ';'
+		ObjectLines = 1,
+		// PayloadCodec output
+		Compressed = 2
+	};
+
+	// where a payload is stored inside a library file
+	struct Location {
+		std::string filename = "";
+		uint64_t offset = 0;
+		uint64_t length = 0;
+		uint8_t encoding = Raw;
+		std::shared_ptr<ObjectLineTable> lines = nullptr;
+	};
+private:
+	std::mutex _mutex;
+
+	std::string _data = "";
+	bool _loaded = true;
+
+	Location _location;
+	uint32_t _generation = 0;
+
+	uint64_t _hash = 0;
+
+	bool decode(const std::string &stored, std::string &data) const;
+
+	bool read(std::string &data) const;
+public:
+	// bumped every time the library file is rewritten, older offsets are not valid anymore
+	static inline uint32_t currentGeneration = 0;
+
+	// FNV-1a
+	static uint64_t hashData(std::string_view data) {
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (char c : data) {
+			hash ^= (uint8_t)c;
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	explicit ObjectPayload(std::string data) : _data(std::move(data)) {
+		_location.length = _data.size();
+
+		_hash = hashData(_data);
+	}
+
+	// the hash of a payload in a library file is stored in its index
+	ObjectPayload(Location location, uint64_t hash) : _hash(hash) {
+		moveTo(std::move(location), currentGeneration);
+	}
+
+	// a copy of the objects; a payload that is on disk is read every time and never kept in memory
+	std::string get() {
+		std::string data;
+
+		visit([&](std::string_view objects) {
+			data = objects;
+		});
+
+		return data;
+	}
+
+	// hands the objects to `callback` without keeping a payload that is still on disk in memory
+	template <typename F>
+	void visit(F &&callback) {
+		std::lock_guard lock(_mutex);
+
+		if (_loaded) return callback(std::string_view(_data));
+
+		std::string data;
+		read(data);
+
+		callback(std::string_view(data));
+	}
+
+	bool equals(std::string_view data) {
+		bool equal = false;
+
+		visit([&](std::string_view objects) {
+			equal = objects == data;
+		});
+
+		return equal;
+	}
+
+	uint64_t hash() const {
+		return _hash;
+	}
+
+	// makes the payload point into a library file and drops the in-memory copy
+	void moveTo(Location location, uint32_t generation) {
+		std::lock_guard lock(_mutex);
+
+		_location = std::move(location);
+		_generation = generation;
+
+		_data.clear();
+		_data.shrink_to_fit();
+
+		_loaded = _location.length == 0;
+	}
+
+	// true if the payload is read from `offset` of `filename` as it is on disk right now
+	bool storedAt(const std::string &filename, uint64_t offset) {
+		std::lock_guard lock(_mutex);
+
+		return !_loaded && _generation == currentGeneration && _location.offset == offset && _location.filename == filename;
+	}
+
+	// stored size, zero only for empty payloads
+	size_t size() const {
+		return _location.length;
+	}
+};
+
+/**
+ * Content-addressed registry of payloads, so equal object strings share one ObjectPayload.
+ *
+ * The store only keeps weak references: a payload lives as long as some collection
+ * uses it, deleting or importing collections needs no extra bookkeeping.
+ */
+class PayloadStore {
+private:
+	static inline std::mutex _mutex;
+	static inline std::unordered_multimap<uint64_t, std::weak_ptr<ObjectPayload>> _payloads = {};
+	static inline size_t _insertions = 0;
+
+	// drops expired entries every now and then so the map does not grow forever
+	static void insert(uint64_t hash, const std::shared_ptr<ObjectPayload> &payload) {
+		_payloads.emplace(hash, payload);
+
+		if (++_insertions % 1024 != 0) return;
+
+		for (auto it = _payloads.begin(); it != _payloads.end();) {
+			if (it->second.expired()) {
+				it = _payloads.erase(it);
+			} else {
+				it++;
+			}
+		}
+	}
+public:
+	static std::shared_ptr<ObjectPayload> intern(std::string data) {
+		uint64_t hash = ObjectPayload::hashData(data);
+
+		std::lock_guard lock(_mutex);
+
+		auto [begin, end] = _payloads.equal_range(hash);
+
+		for (auto it = begin; it != end; it++) {
+			std::shared_ptr<ObjectPayload> payload = it->second.lock();
+
+			if (payload != nullptr && payload->equals(data)) return payload;
+		}
+
+		auto payload = std::make_shared<ObjectPayload>(std::move(data));
+
+		insert(hash, payload);
+
+		return payload;
+	}
+
+	/**
+	 * Returns the payload stored at `location` of a library file.
+	 * The content is not loaded here, so a live payload is only reused if it points to the
+	 * very same bytes; a hash alone could match a payload of a file that was replaced since.
+	 */
+	static std::shared_ptr<ObjectPayload> add(uint64_t hash, ObjectPayload::Location location) {
+		std::lock_guard lock(_mutex);
+
+		auto [begin, end] = _payloads.equal_range(hash);
+
+		for (auto it = begin; it != end; it++) {
+			std::shared_ptr<ObjectPayload> existing = it->second.lock();
+
+			if (existing != nullptr && existing->storedAt(location.filename, location.offset)) return existing;
+		}
+
+		auto payload = std::make_shared<ObjectPayload>(std::move(location), hash);
+
+		insert(hash, payload);
+
+		return payload;
+	}
+
+	// unique payloads still in use
+	static size_t size() {
+		std::lock_guard lock(_mutex);
+
+		size_t count = 0;
+
+		for (auto &[hash, payload] : _payloads) {
+			if (!payload.expired()) count++;
+		}
+
+		return count;
+	}
+};
+
+/**
+ * Vector whose copies share storage until one of them is changed.
+ *
+ * Copying a library tree only copies the top level node, and changing a node deep
+ * inside it only copies the folders on the path to that node. Like Qt containers,
+ * any non-const access detaches first, so references taken from it belong to this
+ * copy until the vector is copied again.
+ */
+template <typename T>
+class SharedVector {
+private:
+	std::shared_ptr<std::vector<T>> _data;
+
+	std::vector<T> &detach() {
+		if (_data == nullptr) {
+			_data = std::make_shared<std::vector<T>>();
+		} else if (_data.use_count() > 1) {
+			_data = std::make_shared<std::vector<T>>(*_data);
+		}
+
+		return *_data;
+	}
+	const std::vector<T> &view() const {
+		static const std::vector<T> empty = {};
+
+		if (_data == nullptr) return empty;
+
+		return *_data;
+	}
+public:
+	using iterator = typename std::vector<T>::iterator;
+	using const_iterator = typename std::vector<T>::const_iterator;
+
+	SharedVector() = default;
+
+	SharedVector &operator=(std::vector<T> data) {
+		_data = std::make_shared<std::vector<T>>(std::move(data));
+
+		return *this;
+	}
+
+	// true if another copy still uses the same storage
+	bool isShared() const {
+		return _data != nullptr && _data.use_count() > 1;
+	}
+
+	size_t size() const { return view().size(); }
+	bool empty() const { return view().empty(); }
+
+	const T &operator[](size_t i) const { return view()[i]; }
+	T &operator[](size_t i) { return detach()[i]; }
+
+	const T &back() const { return view().back(); }
+	T &back() { return detach().back(); }
+
+	const T *data() const { return view().data(); }
+	T *data() { return detach().data(); }
+
+	const_iterator begin() const { return view().begin(); }
+	const_iterator end() const { return view().end(); }
+	iterator begin() { return detach().begin(); }
+	iterator end() { return detach().end(); }
+
+	void reserve(size_t size) { detach().reserve(size); }
+	void clear() { _data = nullptr; }
+
+	void push_back(const T &value) { detach().push_back(value); }
+	void push_back(T &&value) { detach().push_back(std::move(value)); }
+
+	template <typename... Args>
+	T &emplace_back(Args &&...args) { return detach().emplace_back(std::forward<Args>(args)...); }
+
+	// `pos` has to come from the non-const begin() of this vector
+	iterator erase(iterator pos) { return detach().erase(pos); }
+};
+
+class ListingObject {
+	friend class ListingObjectReader;
+protected:
+public:
+	// older libraries only have 32-bit uids, they are read as is
+	using UniqueID = int64_t;
+protected:
+#define RESTRICTED_UNIQUE_ID 0
+	UniqueID _uniqueID = RESTRICTED_UNIQUE_ID;
+
+	static UniqueID generateUniqueID() {
+		static std::mt19937_64 engine(std::random_device{}() ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count());
+		static uint32_t counter = 0;
+
+		UniqueID uid = RESTRICTED_UNIQUE_ID;
+
+		while (uid == RESTRICTED_UNIQUE_ID) {
+			// 40 random bits above a 23-bit counter, always positive
+			uid = (UniqueID)(((engine() & 0xFFFFFFFFFFull) << 23) | (counter++ & 0x7FFFFF));
+		}
+
+		return uid;
+	}
+
+	void setUniqueID() {
+		_uniqueID = generateUniqueID();
+
+		PMLog::debug("ListingObject::setUniqueID() = {}", _uniqueID);
+	}
+#undef RESTRICTED_UNIQUE_ID
+public:
+	enum ListingObjectType {
+		ObjectCollection,
+		Folder
+	};
+
+	enum ListingObjectType _type = ObjectCollection;
+	std::string _name = "";
+
+	SharedVector<ListingObject> _folderContainer;
+	std::shared_ptr<ObjectPayload> _objectPayload = nullptr;
+	
+	std::string _displayedName = "";
+
+	bool _collectionSelected = false;
+	
+	bool _root = false;
+
+	std::string getObjectDefinition() const {
+		if (_type == ObjectCollection) return "Custom Object";
+		if (_type == Folder) return "Folder";
+
+		return "Unknown Listing Object";
+	}
+
+	ListingObject(const ListingObject &ref) {
+		// PMLog::debug("copy constructor called with id={} ({})", ref.getUniqueID(), ref.getObjectDefinition());
+
+		_uniqueID = ref.getUniqueID();
+		_type = ref._type;
+		_name = ref._name;
+		_folderContainer = ref._folderContainer;
+		_displayedName = ref._displayedName;
+		_collectionSelected = ref._collectionSelected;
+		_objectPayload = ref._objectPayload;
+		_root = ref._root;
+	}
+	ListingObject(ListingObject &&ref) = default;
+
+	ListingObject &operator=(const ListingObject &ref) = default;
+	ListingObject &operator=(ListingObject &&ref) = default;
+
+	ListingObject(enum ListingObjectType type) {
+		setUniqueID();
+
+		_type = type;
+		_name = "Unnamed " + std::to_string(getUniqueID());
+	}
+	ListingObject() {
+		setUniqueID();
+	}
+	ListingObject(enum ListingObjectType type, UniqueID uniqueID, std::string name) {
+		_type = type;
+		_uniqueID = uniqueID;
+		_name = std::move(name);
+
+		if (_uniqueID == 0) setUniqueID();
+	}
+
+	std::string getObjectContainer() const {
+		if (_objectPayload == nullptr) return "";
+
+		return _objectPayload->get();
+	}
+	// hands the objects to `callback` without copying them or keeping them in memory
+	template <typename F>
+	void visitObjectContainer(F &&callback) const {
+		if (_objectPayload == nullptr) return callback(std::string_view());
+
+		_objectPayload->visit(callback);
+	}
+	void setObjectContainer(std::string objects) {
+		_objectPayload = PayloadStore::intern(std::move(objects));
+	}
+	// "objectContainerLZ4" from exports; a broken value leaves the objects as they are
+	bool setCompressedObjectContainer(std::string_view encoded) {
+		std::string compressed;
+		std::string objects;
+
+		if (!PayloadCodec::fromBase64(encoded, compressed) || !PayloadCodec::decompress(compressed, objects)) {
+			PMLog::warn("ListingObject: could not decompress objects of \"{}\"", _name);
+
+			return false;
+		}
+
+		setObjectContainer(std::move(objects));
+
+		return true;
+	}
+
+	operator nlohmann::json() {
+		return toJson();
+	}
+
+	/**
+	 * Const, so serializing does not detach shared folders.
+	 * With `compress` the objects go to "objectContainerLZ4" as base64 PayloadCodec output.
+	 */
+	nlohmann::json toJson(bool compress = false) const;
+
+	operator std::string() {
+		nlohmann::json j = *this;
+		return j.dump(4);
+	}
+
+	ListingObject(std::string &json_string) {
+		loadJson(nlohmann::json::parse(json_string));
+	}
+
+	// builds the whole tree in one pass over an already parsed document
+	static ListingObject fromJson(const nlohmann::json &data) {
+		ListingObject object(ObjectCollection, -1, "");
+
+		object.loadJson(data);
+
+		return object;
+	}
+
+	void loadJson(const nlohmann::json &data);
+
+	UniqueID getUniqueID() const {
+		return _uniqueID;
+	}
+
+	// hash of the objects, 0 when there are none
+	uint64_t getObjectHash() const {
+		if (_objectPayload == nullptr || _objectPayload->size() == 0) return 0;
+
+		return _objectPayload->hash();
+	}
+
+	// gives this entry a new uid, e.g. when an imported copy clashes with an existing entry
+	void resetUniqueID() {
+		setUniqueID();
+	}
+};
+
+/**
+ * SAX handler that reads an exported JSON array of listing objects.
+ *
+ * Every top level entry is handed to `onEntry` as soon as it is complete,
+ * so only one entry is kept in memory at a time.
+ */
+class ListingObjectReader : public nlohmann::json_sax<nlohmann::json> {
+private:
+	enum Container {
+		TopLevel,
+		Entry,
+		Children,
+		Skipped
+	};
+
+	struct Frame {
+		ListingObject *object;
+		bool hasUniqueID;
+		// objectContainerLZ4 wins over objectContainer, whichever comes first, like in loadJson()
+		bool hasCompressed;
+	};
+
+	std::function<void(ListingObject &&)> _onEntry;
+
+	ListingObject _current = {ListingObject::ObjectCollection, -1, ""};
+
+	std::vector<Container> _containers = {};
+	std::vector<Frame> _frames = {};
+	std::string _key = "";
+
+	bool inEntry() const {
+		return !_containers.empty() && _containers.back() == Entry;
+	}
+
+	template <typename T>
+	bool number(T value) {
+		if (!inEntry()) return true;
+
+		if (_key == "type") {
+			_frames.back().object->_type = (enum ListingObject::ListingObjectType)value;
+		} else if (_key == "uid") {
+			_frames.back().object->_uniqueID = (ListingObject::UniqueID)value;
+			_frames.back().hasUniqueID = true;
+		}
+
+		return true;
+	}
+
+	bool push(Container container) {
+		_containers.push_back(container);
+
+		return true;
+	}
+public:
+	size_t _entries = 0;
+
+	ListingObjectReader(std::function<void(ListingObject &&)> onEntry) : _onEntry(onEntry) {}
+
+	bool null() override { return true; }
+	bool boolean(bool) override { return true; }
+	bool binary(binary_t &) override { return true; }
+
+	bool number_integer(number_integer_t value) override { return number(value); }
+	bool number_unsigned(number_unsigned_t value) override { return number(value); }
+	bool number_float(number_float_t value, const string_t &) override { return number(value); }
+
+	bool string(string_t &value) override {
+		if (!inEntry()) return true;
+
+		if (_key == "name") {
+			_frames.back().object->_name = std::move(value);
+		} else if (_key == "objectContainer") {
+			if (!_frames.back().hasCompressed) _frames.back().object->setObjectContainer(std::move(value));
+		} else if (_key == "objectContainerLZ4") {
+			if (_frames.back().object->setCompressedObjectContainer(value)) _frames.back().hasCompressed = true;
+		}
+
+		return true;
+	}
+
+	bool key(string_t &value) override {
+		if (inEntry()) _key = std::move(value);
+
+		return true;
+	}
+
+	bool start_object(std::size_t) override {
+		// only an array of entries is a valid export
+		if (_containers.empty()) return false;
+
+		if (_containers.back() == TopLevel) {
+			_current = ListingObject(ListingObject::ObjectCollection, -1, "");
+			_frames.push_back({&_current, false, false});
+
+			return push(Entry);
+		}
+
+		if (_containers.back() == Children) {
+			auto &container = _frames.back().object->_folderContainer;
+			container.emplace_back(ListingObject::ObjectCollection, -1, "");
+
+			_frames.push_back({&container.back(), false, false});
+
+			return push(Entry);
+		}
+
+		return push(Skipped);
+	}
+
+	bool end_object() override {
+		Container container = _containers.back();
+		_containers.pop_back();
+
+		if (container != Entry) return true;
+
+		Frame frame = _frames.back();
+		_frames.pop_back();
+
+		if (!frame.hasUniqueID) {
+			frame.object->setUniqueID();
+		}
+
+		if (_frames.empty()) {
+			_entries++;
+			_onEntry(std::move(_current));
+		}
+
+		return true;
+	}
+
+	bool start_array(std::size_t) override {
+		if (_containers.empty()) return push(TopLevel);
+
+		if (inEntry() && _key == "folderContainer") return push(Children);
+
+		return push(Skipped);
+	}
+
+	bool end_array() override {
+		_containers.pop_back();
+
+		return true;
+	}
+
+	bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &ex) override {
+		PMLog::error("ListingObjectReader: {} (at {})", ex.what(), position);
+
+		return false;
+	}
+};
+
+
+/**
+ * Writes listing objects as an exported JSON array straight into a stream.
+ *
+ * The output matches dumping toJson() of every entry, but no document is built,
+ * so exporting only needs memory for the biggest single collection.
+ */
+class ListingObjectWriter {
+private:
+	std::ostream &_out;
+	bool _compress;
+	size_t _entries = 0;
+
+	void writeString(std::string_view value);
+
+	void writeNumber(int64_t value) {
+		char buf[24];
+		auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+
+		_out.write(buf, ptr - buf);
+	}
+
+	void writeKey(const char *key) {
+		writeString(key);
+		_out.put(':');
+	}
+
+	// keys are in the same (sorted) order nlohmann uses
+	void writeObject(const ListingObject &object);
+public:
+	ListingObjectWriter(std::ostream &out, bool compress) : _out(out), _compress(compress) {}
+
+	void begin() {
+		_out.put('[');
+	}
+	void write(const ListingObject &object) {
+		if (_entries++ != 0) _out.put(',');
+
+		writeObject(object);
+	}
+	void end() {
+		_out.put(']');
+	}
+
+	size_t size() const {
+		return _entries;
+	}
+};
@@ -0,0 +1,243 @@
+#include "Numbers.hpp"
+#include "Platform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace PMGlobal {
+	namespace {
+		// powers of ten that doubles hold exactly
+		constexpr double POWERS[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		// a decimal number split into sign, digits and exponent
+		struct DecimalNumber {
+			bool negative = false;
+			uint64_t mantissa = 0;
+			int exponent = 0;
+			// more than 19 significant digits, the ones past that were dropped
+			bool truncated = false;
+		};
+
+		bool scanNumber(std::string_view value, DecimalNumber &number) {
+			size_t i = 0;
+			size_t n = value.size();
+
+			auto isDigit = [&](size_t pos) {
+				return pos < n && value[pos] >= '0' && value[pos] <= '9';
+			};
+
+			if (i < n && (value[i] == '-' || value[i] == '+')) {
+				number.negative = value[i] == '-';
+				i++;
+			}
+
+			int digits = 0;
+			bool any = false;
+
+			for (; isDigit(i); i++) {
+				any = true;
+
+				if (digits < 19) {
+					number.mantissa = number.mantissa * 10 + (value[i] - '0');
+					if (number.mantissa != 0) digits++;
+				} else {
+					number.exponent++;
+					number.truncated = true;
+				}
+			}
+
+			if (i < n && value[i] == '.') {
+				for (i++; isDigit(i); i++) {
+					any = true;
+
+					if (digits < 19) {
+						number.mantissa = number.mantissa * 10 + (value[i] - '0');
+						if (number.mantissa != 0) digits++;
+
+						number.exponent--;
+					} else {
+						number.truncated = true;
+					}
+				}
+			}
+
+			if (!any) return false;
+
+			if (i < n && (value[i] == 'e' || value[i] == 'E')) {
+				size_t pos = i + 1;
+				bool negative = false;
+
+				if (pos < n && (value[pos] == '-' || value[pos] == '+')) {
+					negative = value[pos] == '-';
+					pos++;
+				}
+
+				int exponent = 0;
+
+				for (; isDigit(pos); pos++) {
+					// anything past this is infinity or zero for a float anyway
+					if (exponent < 1000) exponent = exponent * 10 + (value[pos] - '0');
+				}
+
+				number.exponent += negative ? -exponent : exponent;
+			}
+
+			return true;
+		}
+
+		/**
+		 * The digits and the power of ten are exact doubles here, so the division or multiplication
+		 * rounds correctly; narrowing that to a float only goes wrong when it lands right between
+		 * two floats, which are left to the slow path.
+		 */
+		bool toFloatExact(const DecimalNumber &number, float &result) {
+			if (number.truncated || number.mantissa > (1ull << 53)) return false;
+			if (number.exponent < -22 || number.exponent > 22) return false;
+
+			double value = (double)number.mantissa;
+			value = number.exponent < 0 ? value / POWERS[-number.exponent] : value * POWERS[number.exponent];
+
+			float narrow = (float)value;
+
+			if (!std::isfinite(narrow) || (narrow == 0.f && number.mantissa != 0)) return false;
+
+			if ((double)narrow != value) {
+				float neighbour = std::nextafterf(narrow, value > narrow ? INFINITY : -INFINITY);
+
+				if (value == ((double)narrow + neighbour) / 2) return false;
+			}
+
+			result = number.negative ? -narrow : narrow;
+
+			return true;
+		}
+
+#if !PM_FLOAT_CHARCONV
+		/**
+		 * Rewrites shortest output like "1.5e-05" in fixed notation ("0.000015"),
+		 * GD can't read exponents. The digits stay the same, only the point moves.
+		 */
+		char *writeFixed(char *first, char *last, std::string_view shortest) {
+			auto put = [&](char c) {
+				if (first != last) *first++ = c;
+			};
+
+			size_t e = shortest.find_first_of("eE");
+
+			if (e == std::string_view::npos) {
+				for (char c : shortest) put(c);
+
+				return first;
+			}
+
+			std::string_view mantissa = shortest.substr(0, e);
+			int exponent = 0;
+			std::from_chars(shortest.data() + e + 1 + (shortest[e + 1] == '+'), shortest.data() + shortest.size(), exponent);
+
+			if (!mantissa.empty() && mantissa[0] == '-') {
+				put('-');
+				mantissa.remove_prefix(1);
+			}
+
+			char digits[16];
+			int count = 0;
+			int point = -1;
+
+			for (char c : mantissa) {
+				if (c == '.') {
+					point = count;
+				} else if (count < (int)sizeof(digits)) {
+					digits[count++] = c;
+				}
+			}
+
+			if (point < 0) point = count;
+			point += exponent;
+
+			if (point <= 0) {
+				put('0');
+				put('.');
+
+				for (int i = 0; i < -point; i++) put('0');
+				for (int i = 0; i < count; i++) put(digits[i]);
+			} else {
+				for (int i = 0; i < std::max(point, count); i++) {
+					if (i == point) put('.');
+
+					put(i < count ? digits[i] : '0');
+				}
+			}
+
+			return first;
+		}
+#endif
+	}
+
+	float parseFloat(std::string_view value) {
+		DecimalNumber number;
+
+		if (!scanNumber(value, number)) return 0.f;
+
+		float exact;
+		if (toFloatExact(number, exact)) return exact;
+
+		double result = (double)number.mantissa;
+		int exponent = number.exponent;
+
+		while (exponent > 22) {
+			result *= 1e22;
+			exponent -= 22;
+		}
+		while (exponent < -22) {
+			result /= 1e22;
+			exponent += 22;
+		}
+
+		result = exponent < 0 ? result / POWERS[-exponent] : result * POWERS[exponent];
+
+		return (float)(number.negative ? -result : result);
+	}
+
+	float toFloat(std::string_view value) {
+		DecimalNumber number;
+
+		if (!scanNumber(value, number)) return 0.f;
+
+		float result = 0.f;
+
+		if (toFloatExact(number, result)) return result;
+
+#if PM_FLOAT_CHARCONV
+		const char *first = value.data();
+		if (*first == '+') first++;
+
+		auto [ptr, ec] = std::from_chars(first, value.data() + value.size(), result);
+
+		// out of range values read as 0, std::stof used to throw on them
+		if (ec != std::errc()) return 0.f;
+
+		return result;
+#else
+		return parseFloat(value);
+#endif
+	}
+
+	char *writeFloat(char *first, char *last, float value) {
+		// object strings have no room for "-0", "inf" or "nan"
+		if (value == 0.f || !std::isfinite(value)) value = 0.f;
+
+#if PM_FLOAT_CHARCONV
+		return std::to_chars(first, last, value, std::chars_format::fixed).ptr;
+#else
+		// same shortest digits as to_chars, but fmt switches to exponents for small and large values
+		char shortest[32];
+		char *end = fmt::format_to_n(shortest, sizeof(shortest), "{}", value).out;
+
+		return writeFixed(first, last, std::string_view(shortest, end - shortest));
+#endif
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+/**
+ * Numbers in object strings.
+ *
+ * Everything goes through std::from_chars/std::to_chars, so the C locale of the game has no say,
+ * nothing is allocated, and floats are written the way GD writes them: fixed notation with as
+ * few digits as it takes to read the same float back ("15", "97.5", "-0.25").
+ *
+ * Standard libraries without floating point from_chars (libc++ before 20) get a parser of ours
+ * for long numbers, ones without floating point to_chars get fmt's shortest digits, rewritten in
+ * fixed notation. Integers past 2^24 are zero padded there instead of printed exactly, and still
+ * read back the same. PM_FLOAT_CHARCONV=0 forces that path.
+ */
+
+#ifndef PM_FLOAT_CHARCONV
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define PM_FLOAT_CHARCONV 1
+#else
+#define PM_FLOAT_CHARCONV 0
+#endif
+#endif
+
+namespace PMGlobal {
+	// longest fixed notation float, -FLT_MAX has 39 digits before the point
+	constexpr size_t FLOAT_CHARS = 64;
+
+	// 0 for anything that is not a number
+	inline int toInt(std::string_view value) {
+		int result = 0;
+
+		std::from_chars(value.data(), value.data() + value.size(), result);
+
+		return result;
+	}
+
+	// locale independent parser, within a rounding step of from_chars for long numbers
+	float parseFloat(std::string_view value);
+
+	/**
+	 * 0 for anything that is not a number.
+	 *
+	 * Numbers GD writes (a handful of digits and decimals) are read with a single double
+	 * operation, which is exact; the rest goes through from_chars when there is one.
+	 */
+	float toFloat(std::string_view value);
+
+	// writes `value` to [first, last) and returns the end; needs FLOAT_CHARS of room
+	char *writeFloat(char *first, char *last, float value);
+
+	inline char *writeInt(char *first, char *last, int value) {
+		return std::to_chars(first, last, value).ptr;
+	}
+
+	inline void appendFloat(std::string &out, float value) {
+		char buf[FLOAT_CHARS];
+
+		out.append(buf, writeFloat(buf, buf + sizeof(buf), value));
+	}
+
+	inline void appendInt(std::string &out, int value) {
+		char buf[16];
+
+		out.append(buf, writeInt(buf, buf + sizeof(buf), value));
+	}
+
+	inline std::string formatFloat(float value) {
+		std::string out;
+		appendFloat(out, value);
+
+		return out;
+	}
+}
@@ -0,0 +1,137 @@
+#include "ObjectString.hpp"
+
+namespace PMGlobal {
+	std::vector<std::string> splitString(const char *str, char d, unsigned int max_entries) {
+		std::vector<std::string> result;
+
+		StringTokenizer tokenizer(str, d);
+		std::string_view token;
+
+		while (tokenizer.next(token)) {
+			result.emplace_back(token);
+
+			if (max_entries > 0 && result.size() > max_entries) {
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	ObjectRecord parseObjectData(std::string_view object_string, char delim) {
+		return ObjectRecord(object_string, delim);
+	}
+
+	cocos2d::CCPoint getPositionFromString(std::string_view object_string) {
+		cocos2d::CCPoint p = {0.f, 0.f};
+
+		KVTokenizer tokenizer(object_string);
+
+		int key;
+		std::string_view value;
+		int found = 0;
+
+		while (found != 2 && tokenizer.next(key, value)) {
+			if (key == 2) {
+				p.x = toFloat(value);
+				found++;
+			} else if (key == 3) {
+				p.y = toFloat(value);
+				found++;
+			}
+		}
+
+		return p;
+	}
+
+	cocos2d::CCPoint getPositionFromString(ObjectRecord &record) {
+		return record.getPosition();
+	}
+
+	std::string buildKVString(ObjectRecord &record) {
+		return record.toString();
+	}
+
+	void appendKV(std::string &out, int key, std::string_view value) {
+		if (!out.empty()) out += ',';
+
+		char buf[16];
+		auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), key);
+
+		out.append(buf, ptr);
+		out += ',';
+		out += value;
+	}
+
+	std::string setPositionToString(std::string_view object_string, cocos2d::CCPoint pos) {
+		std::string res;
+		res.reserve(object_string.size() + 32);
+
+		char x_buf[FLOAT_CHARS];
+		char y_buf[FLOAT_CHARS];
+
+		std::string_view x(x_buf, writeFloat(x_buf, x_buf + sizeof(x_buf), pos.x) - x_buf);
+		std::string_view y(y_buf, writeFloat(y_buf, y_buf + sizeof(y_buf), pos.y) - y_buf);
+
+		KVTokenizer tokenizer(object_string);
+
+		int key;
+		std::string_view value;
+		bool has_x = false;
+		bool has_y = false;
+
+		while (tokenizer.next(key, value)) {
+			if (key == 2) {
+				if (has_x) continue;
+
+				appendKV(res, key, x);
+				has_x = true;
+			} else if (key == 3) {
+				if (has_y) continue;
+
+				appendKV(res, key, y);
+				has_y = true;
+			} else {
+				appendKV(res, key, value);
+			}
+		}
+
+		if (!has_x) appendKV(res, 2, x);
+		if (!has_y) appendKV(res, 3, y);
+
+		return res;
+	}
+
+	void appendMovedObject(std::string &out, std::string_view object_string, cocos2d::CCPoint delta) {
+		KVTokenizer tokenizer(object_string);
+
+		int key;
+		std::string_view value;
+		bool first = true;
+		char buf[16];
+
+		while (tokenizer.next(key, value)) {
+			if (!first) out += ',';
+			first = false;
+
+			auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), key);
+
+			out.append(buf, ptr);
+			out += ',';
+
+			if (key == 2) {
+				appendFloat(out, toFloat(value) + delta.x);
+			} else if (key == 3) {
+				appendFloat(out, toFloat(value) + delta.y);
+			} else {
+				out += value;
+			}
+		}
+	}
+
+	std::string setPositionToString(ObjectRecord &record, cocos2d::CCPoint pos) {
+		record.setPosition(pos);
+
+		return record.toString();
+	}
+}
@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Platform.hpp"
+#include "Numbers.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PMGlobal {
+	/**
+	 * Walks over a string and yields every non-empty token between delimiters.
+	 *
+	 * Tokens are views into the source string, so the source should outlive the tokenizer.
+	 */
+	class StringTokenizer {
+	private:
+		std::string_view _str;
+		char _delim;
+		size_t _pos = 0;
+	public:
+		StringTokenizer(std::string_view str, char delim) : _str(str), _delim(delim) {}
+
+		bool next(std::string_view &token) {
+			while (_pos < _str.size()) {
+				size_t end = _str.find(_delim, _pos);
+				if (end == std::string_view::npos) end = _str.size();
+
+				token = _str.substr(_pos, end - _pos);
+				_pos = end + 1;
+
+				if (!token.empty()) return true;
+			}
+
+			return false;
+		}
+	};
+
+	/**
+	 * Walks over a key-value string like "1,1,2,15,3,15" and yields (key, value) pairs.
+	 *
+	 * Values are views into the source string and can be empty.
+	 * Pairs with a non-numeric key and a trailing key without value are skipped.
+	 */
+	class KVTokenizer {
+	private:
+		std::string_view _str;
+		char _delim;
+		size_t _pos = 0;
+
+		bool nextRaw(std::string_view &token) {
+			if (_pos >= _str.size()) return false;
+
+			size_t end = _str.find(_delim, _pos);
+			if (end == std::string_view::npos) end = _str.size();
+
+			token = _str.substr(_pos, end - _pos);
+			_pos = end + 1;
+
+			return true;
+		}
+	public:
+		KVTokenizer(std::string_view str, char delim = ',') : _str(str), _delim(delim) {}
+
+		bool next(int &key, std::string_view &value) {
+			std::string_view key_token;
+
+			while (nextRaw(key_token)) {
+				// stray delimiter (e.g. "1,1,,2,15" or a trailing one)
+				if (key_token.empty()) continue;
+
+				if (!nextRaw(value)) return false;
+
+				auto [ptr, ec] = std::from_chars(key_token.data(), key_token.data() + key_token.size(), key);
+				if (ec != std::errc() || ptr != key_token.data() + key_token.size()) continue;
+
+				return true;
+			}
+
+			return false;
+		}
+	};
+
+	std::vector<std::string> splitString(const char *str, char d, unsigned int max_entries = 0);
+
+	/**
+	 * Flat property record of a single object.
+	 *
+	 * The object string is kept in one buffer and properties are addressed through
+	 * a table of (key, offset, length) entries sorted by key.
+	 */
+	class ObjectRecord {
+	public:
+		struct Entry {
+			uint16_t key;
+			uint32_t offset;
+			uint32_t length;
+		};
+	private:
+		std::string _buffer;
+		std::vector<Entry> _entries;
+
+		const Entry *find(int key) const {
+			auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const Entry &e, int k) {
+				return e.key < k;
+			});
+
+			if (it == _entries.end() || it->key != key) return nullptr;
+
+			return &(*it);
+		}
+	public:
+		// keys are stored as uint16_t; gd uses far less than that
+		static constexpr int MAX_KEY = 0xFFFF;
+
+		ObjectRecord() {}
+
+		explicit ObjectRecord(std::string_view object_string, char delim = ',') {
+			assign(object_string, delim);
+		}
+
+		// parses `object_string` into this record, reusing its buffers
+		void assign(std::string_view object_string, char delim = ',') {
+			_buffer.assign(object_string);
+			_entries.clear();
+
+			KVTokenizer tokenizer(_buffer, delim);
+
+			int key;
+			std::string_view value;
+
+			while (tokenizer.next(key, value)) {
+				if (key < 0 || key > MAX_KEY) continue;
+
+				_entries.push_back({(uint16_t)key, (uint32_t)(value.data() - _buffer.data()), (uint32_t)value.size()});
+			}
+
+			// insertion sort is stable, so the last of duplicate keys can win. objects only have
+			// a few dozen keys, mostly in order, and unlike std::stable_sort it never allocates
+			for (size_t i = 1; i < _entries.size(); i++) {
+				Entry entry = _entries[i];
+				size_t j = i;
+
+				for (; j > 0 && _entries[j - 1].key > entry.key; j--) {
+					_entries[j] = _entries[j - 1];
+				}
+
+				_entries[j] = entry;
+			}
+
+			auto last = std::unique(_entries.rbegin(), _entries.rend(), [](const Entry &a, const Entry &b) {
+				return a.key == b.key;
+			});
+			_entries.erase(_entries.begin(), last.base());
+		}
+
+		bool has(int key) const {
+			return find(key) != nullptr;
+		}
+
+		std::string_view get(int key) const {
+			const Entry *entry = find(key);
+
+			if (!entry) return {};
+
+			return value(*entry);
+		}
+
+		std::string_view value(const Entry &entry) const {
+			return std::string_view(_buffer).substr(entry.offset, entry.length);
+		}
+
+		void set(int key, std::string_view value) {
+			if (key < 0 || key > MAX_KEY) return;
+
+			auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const Entry &e, int k) {
+				return e.key < k;
+			});
+
+			// shorter values are overwritten in place, longer ones are appended to the buffer
+			if (it != _entries.end() && it->key == key && value.size() <= it->length) {
+				_buffer.replace(it->offset, value.size(), value);
+				it->length = value.size();
+
+				return;
+			}
+
+			Entry entry = {(uint16_t)key, (uint32_t)_buffer.size(), (uint32_t)value.size()};
+			_buffer += value;
+
+			if (it != _entries.end() && it->key == key) {
+				*it = entry;
+			} else {
+				_entries.insert(it, entry);
+			}
+		}
+
+		void remove(int key) {
+			const Entry *entry = find(key);
+
+			if (!entry) return;
+
+			_entries.erase(_entries.begin() + (entry - _entries.data()));
+		}
+
+		const std::vector<Entry> &entries() const {
+			return _entries;
+		}
+
+		size_t size() const {
+			return _entries.size();
+		}
+
+		bool empty() const {
+			return _entries.empty();
+		}
+
+		int getObjectID() const {
+			return toInt(get(1));
+		}
+
+		cocos2d::CCPoint getPosition() const {
+			return {toFloat(get(2)), toFloat(get(3))};
+		}
+		void setPosition(cocos2d::CCPoint pos) {
+			char buf[FLOAT_CHARS];
+
+			set(2, std::string_view(buf, writeFloat(buf, buf + sizeof(buf), pos.x) - buf));
+			set(3, std::string_view(buf, writeFloat(buf, buf + sizeof(buf), pos.y) - buf));
+		}
+
+		std::vector<int> getGroups() const {
+			std::vector<int> groups;
+
+			StringTokenizer tokenizer(get(57), '.');
+			std::string_view group;
+
+			while (tokenizer.next(group)) {
+				groups.push_back(toInt(group));
+			}
+
+			return groups;
+		}
+		void setGroups(const std::vector<int> &groups) {
+			if (groups.empty()) {
+				remove(57);
+
+				return;
+			}
+
+			std::string value;
+
+			for (int group : groups) {
+				if (!value.empty()) value += '.';
+
+				appendInt(value, group);
+			}
+
+			set(57, value);
+		}
+
+		void appendTo(std::string &out, char delim = ',') const {
+			char buf[16];
+			bool first = true;
+
+			for (const Entry &entry : _entries) {
+				if (!first) out += delim;
+				first = false;
+
+				auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), (int)entry.key);
+
+				out.append(buf, ptr);
+				out += delim;
+				out += value(entry);
+			}
+		}
+
+		std::string toString(char delim = ',') const {
+			std::string res;
+			res.reserve(_buffer.size() + _entries.size());
+
+			appendTo(res, delim);
+
+			return res;
+		}
+	};
+
+	ObjectRecord parseObjectData(std::string_view object_string, char delim = ',');
+
+	cocos2d::CCPoint getPositionFromString(std::string_view object_string);
+	cocos2d::CCPoint getPositionFromString(ObjectRecord &record);
+
+	std::string buildKVString(ObjectRecord &record);
+
+	void appendKV(std::string &out, int key, std::string_view value);
+
+	std::string setPositionToString(std::string_view object_string, cocos2d::CCPoint pos);
+	std::string setPositionToString(ObjectRecord &record, cocos2d::CCPoint pos);
+
+	// appends `object_string` to `out` with its position moved by `delta`
+	void appendMovedObject(std::string &out, std::string_view object_string, cocos2d::CCPoint delta);
+
+	/**
+	 * Object collection parsed once for stamping.
+	 *
+	 * Every object is read into an ObjectRecord once; its position is kept apart and the rest of
+	 * its properties go into one shared buffer. Building a stamped object only needs to format
+	 * the new position.
+	 */
+	class CollectionTemplate {
+	private:
+		struct Object {
+			cocos2d::CCPoint position;
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		std::string _buffer;
+		std::vector<Object> _objects;
+	public:
+		CollectionTemplate() {}
+
+		explicit CollectionTemplate(std::string_view collection) {
+			_buffer.reserve(collection.size());
+
+			StringTokenizer objects(collection, ';');
+			std::string_view object_string;
+
+			// one record for every object, its buffers are reused
+			ObjectRecord record;
+
+			while (objects.next(object_string)) {
+				record.assign(object_string);
+
+				Object object = {record.getPosition(), (uint32_t)_buffer.size(), 0};
+
+				record.remove(2);
+				record.remove(3);
+
+				if (!record.empty()) {
+					_buffer += ',';
+					record.appendTo(_buffer);
+				}
+
+				object.length = _buffer.size() - object.offset;
+
+				_objects.push_back(object);
+			}
+
+			_buffer.shrink_to_fit();
+		}
+
+		bool empty() const {
+			return _objects.empty();
+		}
+
+		size_t size() const {
+			return _objects.size();
+		}
+
+		// appends all objects moved by `offset` to `out` as one ';' separated string
+		void build(cocos2d::CCPoint offset, std::string &out) const {
+			// position keys take ~16 characters per object
+			out.reserve(out.size() + _buffer.size() + _objects.size() * 24);
+
+			for (size_t i = 0; i < _objects.size(); i++) {
+				if (i != 0) out += ';';
+
+				buildObject(i, offset, out);
+			}
+		}
+
+		// appends object at `index` moved by `offset` to `out`
+		void buildObject(size_t index, cocos2d::CCPoint offset, std::string &out) const {
+			const Object &object = _objects[index];
+
+			out += "2,";
+			appendFloat(out, object.position.x + offset.x);
+			out += ",3,";
+			appendFloat(out, object.position.y + offset.y);
+			out.append(_buffer, object.offset, object.length);
+		}
+	};
+}
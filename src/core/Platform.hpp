@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * Everything the core sources need from the game.
+ *
+ * The mod build takes it from Geode. The headless build (BETTEROBJECTS_HEADLESS) only
+ * needs the few plain cocos2d value types the core uses, and logs through fmt.
+ */
+
+#ifdef BETTEROBJECTS_HEADLESS
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <utility>
+
+namespace cocos2d {
+	typedef unsigned char GLubyte;
+
+	struct _ccColor3B {
+		GLubyte r = 0;
+		GLubyte g = 0;
+		GLubyte b = 0;
+	};
+
+	class CCPoint {
+	public:
+		float x = 0.f;
+		float y = 0.f;
+
+		CCPoint() {}
+		CCPoint(float x, float y) : x(x), y(y) {}
+
+		CCPoint operator+(const CCPoint &other) const {
+			return {x + other.x, y + other.y};
+		}
+		CCPoint operator-(const CCPoint &other) const {
+			return {x - other.x, y - other.y};
+		}
+	};
+
+	class CCSize {
+	public:
+		float width = 0.f;
+		float height = 0.f;
+
+		CCSize() {}
+		CCSize(float width, float height) : width(width), height(height) {}
+	};
+
+	class CCRect {
+	public:
+		CCPoint origin;
+		CCSize size;
+
+		CCRect() {}
+		CCRect(float x, float y, float width, float height) : origin(x, y), size(width, height) {}
+	};
+}
+
+// debug output is dropped, so benchmarks don't measure the terminal
+namespace PMLog {
+	template <typename... Args>
+	void debug(fmt::format_string<Args...>, Args &&...) {}
+
+	template <typename... Args>
+	void info(fmt::format_string<Args...> format, Args &&...args) {
+		fmt::print(stderr, "[info] {}\n", fmt::format(format, std::forward<Args>(args)...));
+	}
+	template <typename... Args>
+	void warn(fmt::format_string<Args...> format, Args &&...args) {
+		fmt::print(stderr, "[warn] {}\n", fmt::format(format, std::forward<Args>(args)...));
+	}
+	template <typename... Args>
+	void error(fmt::format_string<Args...> format, Args &&...args) {
+		fmt::print(stderr, "[error] {}\n", fmt::format(format, std::forward<Args>(args)...));
+	}
+}
+
+#else
+
+#include <Geode/Geode.hpp>
+
+namespace PMLog = geode::log;
+
+#endif
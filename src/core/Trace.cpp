@@ -0,0 +1,166 @@
+#include "Trace.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+namespace PMTrace {
+	namespace {
+		std::mutex _mutex;
+
+		std::vector<Event> _buffer;
+		// next slot to write, wraps around once the buffer is full
+		size_t _head = 0;
+
+		std::atomic<uint32_t> _threads = 0;
+
+		const std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+
+		uint32_t threadIndex() {
+			thread_local uint32_t index = ++_threads;
+
+			return index;
+		}
+
+		bool writeFile(const std::filesystem::path &filename, const std::string &data) {
+			std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+			out.write(data.data(), data.size());
+
+			if (!out.good()) {
+				PMLog::error("PMTrace::dump: could not write {}", filename.string());
+
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+	}
+
+	void record(const Event &event) {
+		uint32_t thread = threadIndex();
+
+		std::lock_guard lock(_mutex);
+
+		if (_buffer.size() < CAPACITY) {
+			_buffer.push_back(event);
+			_buffer.back().thread = thread;
+
+			return;
+		}
+
+		_buffer[_head] = event;
+		_buffer[_head].thread = thread;
+
+		_head = (_head + 1) % CAPACITY;
+	}
+
+	std::vector<Event> events() {
+		std::lock_guard lock(_mutex);
+
+		std::vector<Event> result;
+		result.reserve(_buffer.size());
+
+		result.insert(result.end(), _buffer.begin() + _head, _buffer.end());
+		result.insert(result.end(), _buffer.begin(), _buffer.begin() + _head);
+
+		return result;
+	}
+
+	void clear() {
+		std::lock_guard lock(_mutex);
+
+		_buffer.clear();
+		_head = 0;
+	}
+
+	std::string toChromeTrace(const std::vector<Event> &events) {
+		nlohmann::json trace_events = nlohmann::json::array();
+
+		for (const Event &event : events) {
+			nlohmann::json args = nlohmann::json::object();
+
+			if (event.objects >= 0) args["objects"] = event.objects;
+			if (event.bytes >= 0) args["bytes"] = event.bytes;
+
+			// complete events, times are in microseconds
+			trace_events.push_back({
+				{"name", event.name},
+				{"ph", "X"},
+				{"ts", event.start / 1000.0},
+				{"dur", event.duration / 1000.0},
+				{"pid", 1},
+				{"tid", event.thread},
+				{"args", std::move(args)}
+			});
+		}
+
+		nlohmann::json trace = {
+			{"traceEvents", std::move(trace_events)},
+			{"displayTimeUnit", "ms"}
+		};
+
+		return trace.dump();
+	}
+
+	std::string toCSV(const std::vector<Event> &events) {
+		struct Summary {
+			size_t calls = 0;
+			uint64_t total = 0;
+			uint64_t max = 0;
+			int64_t objects = 0;
+			int64_t bytes = 0;
+		};
+
+		std::map<std::string, Summary> summaries;
+
+		for (const Event &event : events) {
+			Summary &summary = summaries[event.name];
+
+			summary.calls++;
+			summary.total += event.duration;
+			summary.max = std::max(summary.max, event.duration);
+
+			if (event.objects > 0) summary.objects += event.objects;
+			if (event.bytes > 0) summary.bytes += event.bytes;
+		}
+
+		std::string csv = "zone,calls,total_ms,mean_us,max_us,objects,bytes,ns_per_object\n";
+
+		for (const auto &[name, summary] : summaries) {
+			csv += fmt::format("{},{},{:.3f},{:.1f},{:.1f},{},{},{:.1f}\n",
+				name,
+				summary.calls,
+				summary.total / 1e6,
+				summary.total / 1e3 / summary.calls,
+				summary.max / 1e3,
+				summary.objects,
+				summary.bytes,
+				summary.objects > 0 ? (double)summary.total / summary.objects : 0.0
+			);
+		}
+
+		return csv;
+	}
+
+	bool dump(const std::string &directory) {
+		std::vector<Event> recorded = events();
+
+		std::filesystem::path path = directory;
+
+		bool result = writeFile(path / "trace.json", toChromeTrace(recorded));
+		result = writeFile(path / "trace.csv", toCSV(recorded)) && result;
+
+		PMLog::info("PMTrace::dump: wrote {} events to {}", recorded.size(), directory);
+
+		return result;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Platform.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped timers for hot paths.
+ *
+ * Zones are only recorded when BETTEROBJECTS_TRACING is defined, otherwise the macros
+ * below expand to nothing and their arguments are not evaluated:
+ *
+ *	PM_TRACE_ZONE(zone, "save");
+ *	PM_TRACE_OBJECTS(zone, nodes);
+ *	PM_TRACE_BYTES(zone, size);
+ *
+ * Finished zones go into a ring buffer of the last PMTrace::CAPACITY events,
+ * which can be written out as a Chrome trace (chrome://tracing, Perfetto) and a CSV summary.
+ */
+namespace PMTrace {
+	constexpr size_t CAPACITY = 16384;
+
+	struct Event {
+		// has to be a string literal
+		const char *name;
+
+		// nanoseconds since the first zone
+		uint64_t start;
+		uint64_t duration;
+
+		uint32_t thread;
+
+		// -1 when the zone didn't say
+		int64_t objects;
+		int64_t bytes;
+	};
+
+	uint64_t now();
+
+	void record(const Event &event);
+
+	// recorded events, oldest first
+	std::vector<Event> events();
+	void clear();
+
+	std::string toChromeTrace(const std::vector<Event> &events);
+	// one row per zone name: calls, total/mean/max time and object and byte totals
+	std::string toCSV(const std::vector<Event> &events);
+
+	// writes trace.json and trace.csv into `directory`
+	bool dump(const std::string &directory);
+
+	class Zone {
+	private:
+		Event _event;
+	public:
+		explicit Zone(const char *name) : _event{name, now(), 0, 0, -1, -1} {}
+		~Zone() {
+			_event.duration = now() - _event.start;
+
+			record(_event);
+		}
+
+		Zone(const Zone &) = delete;
+		Zone &operator=(const Zone &) = delete;
+
+		void setObjects(int64_t objects) {
+			_event.objects = objects;
+		}
+		void setBytes(int64_t bytes) {
+			_event.bytes = bytes;
+		}
+	};
+}
+
+#ifdef BETTEROBJECTS_TRACING
+#define PM_TRACE_ZONE(zone, name) PMTrace::Zone zone(name)
+#define PM_TRACE_OBJECTS(zone, objects) zone.setObjects(objects)
+#define PM_TRACE_BYTES(zone, bytes) zone.setBytes(bytes)
+#else
+#define PM_TRACE_ZONE(zone, name)
+#define PM_TRACE_OBJECTS(zone, objects) ((void)0)
+#define PM_TRACE_BYTES(zone, bytes) ((void)0)
+#endif
@@ -1,648 +1,1751 @@
 #include <Geode/Geode.hpp>
 #include <nlohmann/json.hpp>
 
+#include "core/ListingObject.hpp"
+#include "core/ObjectString.hpp"
+#include "core/LevelColors.hpp"
+#include "core/Trace.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace geode::prelude;
 
 #include <Geode/modify/LevelEditorLayer.hpp>
 #include <Geode/modify/MenuLayer.hpp>
 #include <Geode/modify/EditorUI.hpp>
 #include <Geode/modify/GameObject.hpp>
+#include <Geode/modify/EditorPauseLayer.hpp>
 
-class ListingExParams {
-public:
-	bool _custom = false;
-	float _origScale = 1.f;
+std::vector<std::string> _createObjectsFromColors();
+
+class ListingObjectInteractionPopup;
+
+namespace PMGlobal {
+	using UniqueID = ListingObject::UniqueID;
+
+	struct CollectionStructure {
+		UniqueID uniqueID;
+		CCPoint position;
+	};
+
+	/**
+	 * Placed collections bucketed by the grid cell of their position.
+	 *
+	 * Lookups by position only look at one cell instead of every placed collection.
+	 */
+	class StructureIndex {
+	private:
+		static constexpr float CELL_SIZE = 240.f;
+
+		std::unordered_map<uint64_t, std::vector<CollectionStructure>> _cells;
+		size_t _count = 0;
+
+		// clamped, so positions far outside any level (or NaN) land in the outermost cells
+		static int32_t cellCoord(float v) {
+			float cell = std::floor(v / CELL_SIZE);
+
+			if (!(cell > (float)INT32_MIN)) return INT32_MIN;
+			if (cell >= (float)INT32_MAX) return INT32_MAX;
+
+			return (int32_t)cell;
+		}
+		static uint64_t cellKey(int32_t x, int32_t y) {
+			return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+		}
+		static uint64_t cellKey(CCPoint pos) {
+			return cellKey(cellCoord(pos.x), cellCoord(pos.y));
+		}
+
+		static bool samePlace(const CollectionStructure &a, UniqueID uniqueID, CCPoint pos) {
+			return a.uniqueID == uniqueID && a.position.x == pos.x && a.position.y == pos.y;
+		}
+	public:
+		void insert(const CollectionStructure &structure) {
+			_cells[cellKey(structure.position)].push_back(structure);
+			_count++;
+		}
+
+		bool contains(UniqueID uniqueID, CCPoint pos) const {
+			auto it = _cells.find(cellKey(pos));
+
+			if (it == _cells.end()) return false;
+
+			for (const CollectionStructure &structure : it->second) {
+				if (samePlace(structure, uniqueID, pos)) return true;
+			}
+
+			return false;
+		}
+
+		std::vector<CollectionStructure> at(CCPoint pos) const {
+			std::vector<CollectionStructure> structures;
+
+			auto it = _cells.find(cellKey(pos));
+
+			if (it == _cells.end()) return structures;
+
+			for (const CollectionStructure &structure : it->second) {
+				if (structure.position.x == pos.x && structure.position.y == pos.y) {
+					structures.push_back(structure);
+				}
+			}
+
+			return structures;
+		}
+
+		bool remove(const CollectionStructure &collection) {
+			auto it = _cells.find(cellKey(collection.position));
+
+			if (it == _cells.end()) return false;
+
+			auto &bucket = it->second;
+
+			for (size_t i = 0; i < bucket.size(); i++) {
+				if (!samePlace(bucket[i], collection.uniqueID, collection.position)) continue;
+
+				bucket[i] = bucket.back();
+				bucket.pop_back();
+
+				if (bucket.empty()) _cells.erase(it);
+
+				_count--;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		void clear() {
+			_cells.clear();
+			_count = 0;
+		}
+
+		size_t size() const {
+			return _count;
+		}
+	};
+
+	ListingObject root = ListingObject::Folder;
+	GJBaseGameLayer *baseGameLayer = nullptr;
+	UniqueID selectedUniqueID = 0;
+	bool triggerButtonActivation = false;
+	bool triggerButtonDisactivation = false;
+	int touchIndex = -502;
+	// level settings string the cached level colors were parsed from
+	std::string _currentLevelHeader;
+	ListingObjectInteractionPopup *instance = nullptr;
+
+	StructureIndex currentStructures;
+
+	bool structureExists(UniqueID uniqueID, CCPoint pos) {
+		return currentStructures.contains(uniqueID, pos);
+	}
+	std::vector<struct CollectionStructure> getStructuresOnPosition(CCPoint pos) {
+		return currentStructures.at(pos);
+	}
+
+	void removeStructureFromList(struct CollectionStructure &collection) {
+		currentStructures.remove(collection);
+	}
+
+	// library operations appended to root.journal since the last snapshot
+	size_t journalEntries = 0;
+
+	// library.bin is rewritten and the journal is cleared after this many operations
+	constexpr size_t JOURNAL_COMPACT_ENTRIES = 256;
+
+	// snapshot written by older versions, only read to migrate it into library.bin
+	std::string getRootPath() {
+		return fmt::format("{}/root.json", Mod::get()->getSaveDir().generic_string());
+	}
+	std::string getJournalPath() {
+		return fmt::format("{}/root.journal", Mod::get()->getSaveDir().generic_string());
+	}
+
+	std::string getLibraryPath() {
+		return fmt::format("{}/library.bin", Mod::get()->getSaveDir().generic_string());
+	}
+
+	// renames a fully written `temp_filename` over `filename`
+	bool replaceFile(const std::string &temp_filename, const std::string &filename) {
+		std::error_code ec;
+		std::filesystem::rename(temp_filename, filename, ec);
+
+		if (ec) {
+			log::error("replaceFile: could not rename {} to {}: {}", temp_filename, filename, ec.message());
+
+			return false;
+		}
+
+		return true;
+	}
+
+	// writes `data` next to `filename` and renames it over, so the file is never left truncated
+	bool writeFileAtomic(const std::string &filename, std::string_view data) {
+		std::string temp_filename = filename + ".tmp";
+
+		{
+			std::ofstream o(temp_filename, std::ios::binary | std::ios::trunc);
+
+			o.write(data.data(), data.size());
+			o.flush();
+
+			if (!o.good()) {
+				log::error("writeFileAtomic: could not write {}", temp_filename);
+
+				return false;
+			}
+		}
+
+		return replaceFile(temp_filename, filename);
+	}
+
+	/**
+	 * library.bin layout (little endian):
+	 *
+	 * "BOLB" u32 version
+	 * payloads, every unique content once
+	 * line table (optional): u32 count, then u32 length and text of every unique object line
+	 * index: every node in preorder as
+	 *   u8 type, i64 uid, u32 name length, name,
+	 *   u64 payload hash, u8 payload encoding, u64 payload offset, u64 payload length, u32 children
+	 * footer: u64 index offset, u64 index length, u64 line table offset, u64 line table length, "BOLB"
+	 *
+	 * Only the index is read on load, payloads are read when a collection needs them.
+	 */
+	constexpr char LIBRARY_MAGIC[4] = {'B', 'O', 'L', 'B'};
+	constexpr uint32_t LIBRARY_VERSION = 2;
+	constexpr size_t LIBRARY_FOOTER_SIZE = sizeof(uint64_t) * 4 + sizeof(LIBRARY_MAGIC);
+	// an index node with an empty name and no children
+	constexpr size_t LIBRARY_NODE_MIN_SIZE = sizeof(uint8_t) * 2 + sizeof(int64_t) + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 3;
+	constexpr int LIBRARY_MAX_DEPTH = 256;
+
+	template <typename T>
+	void writeValue(std::string &out, T value) {
+		appendLittleEndian<T>(out, value);
+	}
+
+	class BinaryReader {
+	private:
+		std::string_view _data;
+		size_t _pos = 0;
+	public:
+		explicit BinaryReader(std::string_view data) : _data(data) {}
+
+		template <typename T>
+		bool read(T &value) {
+			if (_data.size() - _pos < sizeof(T)) return false;
+
+			value = loadLittleEndian<T>(_data.data() + _pos);
+			_pos += sizeof(T);
+
+			return true;
+		}
+
+		bool read(std::string &value, size_t length) {
+			if (_data.size() - _pos < length) return false;
+
+			value.assign(_data.substr(_pos, length));
+			_pos += length;
+
+			return true;
+		}
+
+		size_t remaining() const {
+			return _data.size() - _pos;
+		}
+	};
+
+	struct LibraryWriteOptions {
+		// also stores repeated object lines once, at the cost of slower payload loads
+		bool dedupLines = false;
+		// compresses payloads that are not stored as object lines
+		bool compress = false;
+	};
+
+	struct LibraryWriteState {
+		std::string filename = "";
+		std::string tempFilename = "";
+
+		std::ofstream out;
+		uint64_t position = 0;
+		std::string index = "";
+
+		// where every payload went; equal contents are written once
+		std::unordered_map<ObjectPayload *, ObjectPayload::Location> written = {};
+		std::unordered_multimap<uint64_t, ObjectPayload *> writtenHashes = {};
+		std::vector<std::shared_ptr<ObjectPayload>> payloads = {};
+
+		LibraryWriteOptions options;
+
+		// object lines shared between payloads, only used with `dedupLines`
+		std::unordered_map<std::string, uint32_t> lineIds = {};
+		std::vector<const std::string *> lines = {};
+
+		uint64_t linesOffset = 0;
+		uint64_t linesLength = 0;
+	};
+
+	// stores a payload as indices into the line table of the file
+	std::string encodeObjectLines(LibraryWriteState &state, std::string_view data) {
+		std::string encoded;
+		size_t start = 0;
+
+		while (true) {
+			size_t end = data.find(';', start);
+			std::string_view line = data.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+
+			auto [it, inserted] = state.lineIds.try_emplace(std::string(line), (uint32_t)state.lines.size());
+
+			if (inserted) state.lines.push_back(&it->first);
+
+			writeValue<uint32_t>(encoded, it->second);
+
+			if (end == std::string_view::npos) break;
+
+			start = end + 1;
+		}
+
+		return encoded;
+	}
+
+	ObjectPayload::Location writePayload(LibraryWriteState &state, const std::shared_ptr<ObjectPayload> &payload) {
+		ObjectPayload *ptr = payload.get();
+
+		if (state.written.contains(ptr)) return state.written[ptr];
+
+		uint64_t hash = payload->hash();
+		ObjectPayload::Location location;
+
+		// a payload that is still on disk is only read for as long as it takes to copy it over
+		payload->visit([&](std::string_view data) {
+			auto [begin, end] = state.writtenHashes.equal_range(hash);
+
+			for (auto it = begin; it != end; it++) {
+				if (!it->second->equals(data)) continue;
+
+				location = state.written[it->second];
+
+				return;
+			}
+
+			location.offset = state.position;
+
+			std::string encoded;
+
+			if (state.options.dedupLines) {
+				encoded = encodeObjectLines(state, data);
+				location.encoding = ObjectPayload::ObjectLines;
+			} else if (state.options.compress) {
+				encoded = PayloadCodec::compress(data);
+				location.encoding = ObjectPayload::Compressed;
+			}
+
+			if (location.encoding != ObjectPayload::Raw) {
+				location.length = encoded.size();
+
+				state.out.write(encoded.data(), encoded.size());
+			} else {
+				location.length = data.size();
+
+				state.out.write(data.data(), data.size());
+			}
+
+			state.position += location.length;
+
+			state.writtenHashes.emplace(hash, ptr);
+		});
+
+		state.written[ptr] = location;
+		state.payloads.push_back(payload);
+
+		return location;
+	}
+
+	void writeLibraryNode(LibraryWriteState &state, const ListingObject &node) {
+		ObjectPayload::Location location;
+		uint64_t hash = 0;
+
+		if (node._objectPayload != nullptr && node._objectPayload->size() != 0) {
+			location = writePayload(state, node._objectPayload);
+			hash = node._objectPayload->hash();
+		}
+
+		writeValue<uint8_t>(state.index, node._type);
+		writeValue<int64_t>(state.index, node.getUniqueID());
+		writeValue<uint32_t>(state.index, node._name.size());
+		state.index += node._name;
+		writeValue<uint64_t>(state.index, hash);
+		writeValue<uint8_t>(state.index, location.encoding);
+		writeValue<uint64_t>(state.index, location.offset);
+		writeValue<uint64_t>(state.index, location.length);
+		writeValue<uint32_t>(state.index, node._folderContainer.size());
+
+		for (const ListingObject &child : node._folderContainer) {
+			writeLibraryNode(state, child);
+		}
+	}
+
+	/**
+	 * Writes `tree` next to `filename`, the file is only put in place by commitLibrary().
+	 * Nothing but the payloads' contents is touched, so it can run off the main thread.
+	 */
+	bool prepareLibrary(LibraryWriteState &state, const std::string &filename, const ListingObject &tree, LibraryWriteOptions options) {
+		PM_TRACE_ZONE(zone, "PMGlobal::prepareLibrary");
+
+		state.filename = filename;
+		state.tempFilename = filename + ".tmp";
+		state.options = options;
+		state.out.open(state.tempFilename, std::ios::binary | std::ios::trunc);
+
+		std::string header(LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+		writeValue<uint32_t>(header, LIBRARY_VERSION);
+
+		state.out.write(header.data(), header.size());
+		state.position = sizeof(LIBRARY_MAGIC) + sizeof(LIBRARY_VERSION);
+
+		writeLibraryNode(state, tree);
+
+		if (!state.lines.empty()) {
+			std::string table;
+			writeValue<uint32_t>(table, state.lines.size());
+
+			for (const std::string *line : state.lines) {
+				writeValue<uint32_t>(table, line->size());
+				table += *line;
+			}
+
+			state.linesOffset = state.position;
+			state.linesLength = table.size();
+
+			state.out.write(table.data(), table.size());
+			state.position += table.size();
+		}
+
+		std::string footer;
+		writeValue<uint64_t>(footer, state.position);
+		writeValue<uint64_t>(footer, state.index.size());
+		writeValue<uint64_t>(footer, state.linesOffset);
+		writeValue<uint64_t>(footer, state.linesLength);
+		footer.append(LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+
+		state.out.write(state.index.data(), state.index.size());
+		state.out.write(footer.data(), footer.size());
+		state.out.flush();
+
+		if (!state.out.good()) {
+			log::error("prepareLibrary: could not write {}", state.tempFilename);
+
+			return false;
+		}
+
+		state.out.close();
+
+		PM_TRACE_OBJECTS(zone, state.payloads.size());
+		PM_TRACE_BYTES(zone, state.position + state.index.size() + footer.size());
+
+		log::debug("prepareLibrary: {} unique payloads, {} unique object lines", state.writtenHashes.size(), state.lines.size());
+
+		return true;
+	}
+
+	/**
+	 * Puts a prepared library file in place and points the written payloads into it.
+	 * Payloads of the previous file can be read from the main thread, so this has to run there.
+	 */
+	bool commitLibrary(LibraryWriteState &state) {
+		PM_TRACE_ZONE(zone, "PMGlobal::commitLibrary");
+		PM_TRACE_OBJECTS(zone, state.payloads.size());
+
+		if (!replaceFile(state.tempFilename, state.filename)) return false;
+
+		// payloads from the previous file are invalid now; point ours into the new one
+		ObjectPayload::currentGeneration++;
+
+		auto lines = state.linesLength != 0 ? std::make_shared<ObjectLineTable>(state.filename, state.linesOffset, state.linesLength) : nullptr;
+
+		for (auto &payload : state.payloads) {
+			ObjectPayload::Location location = state.written[payload.get()];
+
+			location.filename = state.filename;
+			if (location.encoding == ObjectPayload::ObjectLines) location.lines = lines;
+
+			payload->moveTo(std::move(location), ObjectPayload::currentGeneration);
+		}
+
+		return true;
+	}
+
+	bool writeLibrary(const std::string &filename, const ListingObject &tree, LibraryWriteOptions options = {}) {
+		LibraryWriteState state;
+
+		return prepareLibrary(state, filename, tree, options) && commitLibrary(state);
+	}
+
+	struct LibraryReadState {
+		std::string filename;
+		// payloads are stored in [header, payloadsEnd)
+		uint64_t payloadsEnd;
+		std::shared_ptr<ObjectLineTable> lines = nullptr;
+
+		// nodes sharing a payload in the file share it in memory too
+		std::unordered_map<uint64_t, std::shared_ptr<ObjectPayload>> payloads = {};
+	};
+
+	bool readLibraryNode(BinaryReader &reader, LibraryReadState &state, ListingObject &node, int depth) {
+		if (depth > LIBRARY_MAX_DEPTH) return false;
+
+		uint8_t type;
+		int64_t uid;
+		uint32_t name_length;
+		std::string name;
+		uint64_t hash = 0;
+		uint8_t encoding = ObjectPayload::Raw;
+		uint64_t offset, length;
+		uint32_t children;
+
+		if (!reader.read(type) || !reader.read(uid) || !reader.read(name_length)) return false;
+		if (!reader.read(name, name_length)) return false;
+		if (!reader.read(hash) || !reader.read(encoding)) return false;
+		if (!reader.read(offset) || !reader.read(length) || !reader.read(children)) return false;
+
+		if (encoding == ObjectPayload::ObjectLines && state.lines == nullptr) return false;
+		if (length > state.payloadsEnd || offset > state.payloadsEnd - length) return false;
+
+		// a broken count must not reserve more children than the index can hold
+		if (children > reader.remaining() / LIBRARY_NODE_MIN_SIZE) return false;
+
+		node = ListingObject((enum ListingObject::ListingObjectType)type, uid, std::move(name));
+
+		if (length != 0) {
+			auto &payload = state.payloads[offset];
+
+			if (payload == nullptr) {
+				ObjectPayload::Location location = {state.filename, offset, length, encoding, state.lines};
+
+				payload = PayloadStore::add(hash, std::move(location));
+			}
+
+			node._objectPayload = payload;
+		}
+
+		node._folderContainer.reserve(children);
+
+		for (uint32_t i = 0; i < children; i++) {
+			ListingObject child(ListingObject::ObjectCollection, -1, "");
+
+			if (!readLibraryNode(reader, state, child, depth + 1)) return false;
+
+			node._folderContainer.push_back(std::move(child));
+		}
+
+		return true;
+	}
+
+	bool readLibrary(const std::string &filename, ListingObject &tree) {
+		std::ifstream in(filename, std::ios::binary | std::ios::ate);
+
+		uint64_t file_size = in.tellg();
+
+		char header[sizeof(LIBRARY_MAGIC) + sizeof(uint32_t)];
+		char footer[LIBRARY_FOOTER_SIZE];
+
+		if (!in.good() || file_size < sizeof(header) + LIBRARY_FOOTER_SIZE) return false;
+
+		in.seekg(0);
+		in.read(header, sizeof(header));
+
+		uint32_t version = loadLittleEndian<uint32_t>(header + sizeof(LIBRARY_MAGIC));
+
+		if (!in.good() || std::memcmp(header, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) != 0 || version != LIBRARY_VERSION) {
+			log::error("readLibrary: {} is not a library file", filename);
+
+			return false;
+		}
+
+		in.seekg(file_size - LIBRARY_FOOTER_SIZE);
+		in.read(footer, LIBRARY_FOOTER_SIZE);
+
+		uint64_t index_offset, index_length;
+		uint64_t lines_offset, lines_length;
+
+		BinaryReader footer_reader({footer, LIBRARY_FOOTER_SIZE});
+		footer_reader.read(index_offset);
+		footer_reader.read(index_length);
+		footer_reader.read(lines_offset);
+		footer_reader.read(lines_length);
+
+		uint64_t index_end = file_size - LIBRARY_FOOTER_SIZE;
+
+		// written so that no sum of offsets and lengths from the file can overflow
+		bool broken = !in.good() || std::memcmp(footer + LIBRARY_FOOTER_SIZE - sizeof(LIBRARY_MAGIC), LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) != 0;
+		broken = broken || index_length > index_end - sizeof(header) || index_offset != index_end - index_length;
+		broken = broken || lines_length > index_offset || lines_offset > index_offset - lines_length;
+
+		if (broken) {
+			log::error("readLibrary: {} has a broken footer", filename);
+
+			return false;
+		}
+
+		std::string index(index_length, '\0');
+
+		in.seekg(index_offset);
+		in.read(index.data(), index_length);
+
+		BinaryReader reader(index);
+
+		LibraryReadState state = {filename, lines_length != 0 ? lines_offset : index_offset};
+
+		if (lines_length != 0) {
+			state.lines = std::make_shared<ObjectLineTable>(filename, lines_offset, lines_length);
+		}
+
+		if (!in.good() || !readLibraryNode(reader, state, tree, 0)) {
+			log::error("readLibrary: {} has a broken index", filename);
+
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Library-wide map from uid to the folder holding the entry.
+	 *
+	 * Entries also remember their position inside the folder. Positions go stale when
+	 * siblings are removed, lookups then repair them with one scan of that folder.
+	 */
+	class LibraryIndex {
+	private:
+		struct Entry {
+			UniqueID parent;
+			size_t position;
+		};
+
+		static constexpr size_t UNKNOWN_POSITION = SIZE_MAX;
+
+		std::unordered_map<UniqueID, Entry> _entries;
+		UniqueID _rootID = 0;
+
+		void addRecursive(UniqueID parent, const ListingObject &entry, size_t position) {
+			_entries[entry.getUniqueID()] = {parent, position};
+
+			for (size_t i = 0; i < entry._folderContainer.size(); i++) {
+				addRecursive(entry.getUniqueID(), entry._folderContainer[i], i);
+			}
+		}
+	public:
+		void rebuild(const ListingObject &tree) {
+			_entries.clear();
+			_rootID = tree.getUniqueID();
+
+			for (size_t i = 0; i < tree._folderContainer.size(); i++) {
+				addRecursive(_rootID, tree._folderContainer[i], i);
+			}
+		}
+
+		bool contains(UniqueID uid) const {
+			return uid == _rootID || _entries.contains(uid);
+		}
+
+		size_t size() const {
+			return _entries.size();
+		}
+
+		void add(UniqueID parent, const ListingObject &entry, size_t position = UNKNOWN_POSITION) {
+			addRecursive(parent, entry, position);
+		}
+
+		void remove(const ListingObject &entry) {
+			_entries.erase(entry.getUniqueID());
+
+			for (const ListingObject &child : entry._folderContainer) {
+				remove(child);
+			}
+		}
+
+		UniqueID getParent(UniqueID uid) const {
+			auto it = _entries.find(uid);
+
+			if (it == _entries.end()) return 0;
+
+			return it->second.parent;
+		}
+
+		// `tree` has to be the tree this index was built for
+		ListingObject *find(ListingObject &tree, UniqueID uid) {
+			if (uid == _rootID) return &tree;
+
+			auto it = _entries.find(uid);
+
+			if (it == _entries.end()) return nullptr;
+
+			ListingObject *parent = find(tree, it->second.parent);
+
+			if (parent == nullptr) return nullptr;
+
+			auto &container = parent->_folderContainer;
+			size_t position = it->second.position;
+
+			if (position < container.size() && container[position].getUniqueID() == uid) {
+				return &container[position];
+			}
+
+			for (size_t i = 0; i < container.size(); i++) {
+				if (container[i].getUniqueID() != uid) continue;
+
+				it->second.position = i;
+
+				return &container[i];
+			}
+
+			return nullptr;
+		}
+	};
+
+	// index over `root`
+	LibraryIndex libraryIndex;
+
+	// same name, type, objects and children; uids are not compared
+	bool sameContent(const ListingObject &a, const ListingObject &b) {
+		if (a._type != b._type || a._name != b._name || a.getObjectHash() != b.getObjectHash()) return false;
+		if (a._folderContainer.size() != b._folderContainer.size()) return false;
+
+		for (size_t i = 0; i < a._folderContainer.size(); i++) {
+			if (!sameContent(a._folderContainer[i], b._folderContainer[i])) return false;
+		}
+
+		return true;
+	}
+
+	// gives new uids to `entry` and its children where they are already used in the library
+	void makeUniqueIDsFree(ListingObject &entry) {
+		if (libraryIndex.contains(entry.getUniqueID())) {
+			entry.resetUniqueID();
+		}
+
+		for (ListingObject &child : entry._folderContainer) {
+			makeUniqueIDsFree(child);
+		}
+	}
+
+	/**
+	 * Applies a single journal operation to `tree` (which is `root`).
+	 *
+	 * Operations are idempotent, so replaying a journal that was already
+	 * folded into the snapshot (e.g. after a crash during compaction) is harmless.
+	 */
+	void applyJournalOperation(ListingObject &tree, nlohmann::json &op) {
+		std::string type = op.value("op", "");
+		UniqueID uid = op.value("uid", (UniqueID)0);
+
+		if (type == "add") {
+			if (!op.contains("entry") || !op["entry"].is_object()) return;
+
+			ListingObject entry = ListingObject::fromJson(op["entry"]);
+			ListingObject *parent = libraryIndex.find(tree, op.value("parent", (UniqueID)0));
+
+			if (parent == nullptr || libraryIndex.contains(entry.getUniqueID())) return;
+
+			parent->_folderContainer.push_back(std::move(entry));
+			libraryIndex.add(parent->getUniqueID(), parent->_folderContainer.back(), parent->_folderContainer.size() - 1);
+		} else if (type == "remove") {
+			ListingObject *entry = libraryIndex.find(tree, uid);
+			ListingObject *parent = libraryIndex.find(tree, libraryIndex.getParent(uid));
+
+			if (entry == nullptr || parent == nullptr) return;
+
+			libraryIndex.remove(*entry);
+
+			auto &container = parent->_folderContainer;
+			container.erase(container.begin() + (entry - container.data()));
+		} else if (type == "rename") {
+			ListingObject *entry = libraryIndex.find(tree, uid);
+
+			if (entry != nullptr) entry->_name = op.value("name", entry->_name);
+		} else {
+			log::warn("applyJournalOperation: unknown operation \"{}\"", type);
+		}
+	}
+
+	// size and modification time of a file, to notice when something else changed it
+	struct FileStamp {
+		bool exists = false;
+		uintmax_t size = 0;
+		std::filesystem::file_time_type time = {};
+
+		bool operator==(const FileStamp &) const = default;
+
+		static FileStamp of(const std::string &filename) {
+			FileStamp stamp;
+			std::error_code ec;
+
+			stamp.size = std::filesystem::file_size(filename, ec);
+			if (ec) return {};
+
+			stamp.time = std::filesystem::last_write_time(filename, ec);
+			if (ec) return {};
+
+			stamp.exists = true;
+
+			return stamp;
+		}
+	};
+
+	struct LibraryStamp {
+		FileStamp library;
+		FileStamp journal;
+
+		bool operator==(const LibraryStamp &) const = default;
+
+		static LibraryStamp of(const std::string &library_path, const std::string &journal_path) {
+			return {FileStamp::of(library_path), FileStamp::of(journal_path)};
+		}
+	};
+
+	/**
+	 * Writes the library and its journal on a thread of its own, so edits never wait for the disk.
+	 *
+	 * Requests are collected until none came for SAVE_DEBOUNCE (SAVE_MAX_DELAY at most) and
+	 * written in order. A snapshot replaces an unwritten older one along with the journal lines
+	 * queued before it. The written file is put in place on the main thread, see commitLibrary().
+	 */
+	class LibraryWriter {
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr auto SAVE_DEBOUNCE = std::chrono::milliseconds(300);
+		static constexpr auto SAVE_MAX_DELAY = std::chrono::milliseconds(2000);
+
+		std::mutex _mutex;
+		std::condition_variable _cv;
+
+		std::thread _thread;
+		bool _running = false;
+		// set by stop(), the thread exits once nothing is pending
+		bool _stopping = false;
+		// a batch is being written
+		bool _busy = false;
+		// skips the debounce until everything is written
+		bool _flush = false;
+
+		Clock::time_point _first;
+		Clock::time_point _last;
+
+		std::string _libraryPath = "";
+		std::string _journalPath = "";
+
+		std::optional<ListingObject> _snapshot;
+		LibraryWriteOptions _options;
+
+		// journal lines queued before and after the latest snapshot
+		std::vector<std::string> _linesBefore = {};
+		std::vector<std::string> _lines = {};
+
+		// prepared file waiting for the main thread, and the journal it replaces
+		std::shared_ptr<LibraryWriteState> _commit = nullptr;
+		std::string _commitJournalPath = "";
+		bool _commitDone = false;
+		bool _commitResult = false;
+
+		// the files as they were after our last write or read
+		LibraryStamp _stamp;
+		bool _stamped = false;
+
+		bool pending() const {
+			return _snapshot.has_value() || !_lines.empty();
+		}
+
+		// called with the lock held, before the request is queued
+		void touch() {
+			Clock::time_point now = Clock::now();
+
+			if (!pending()) _first = now;
+			_last = now;
+
+			_libraryPath = getLibraryPath();
+			_journalPath = getJournalPath();
+
+			if (!_running) {
+				_running = true;
+
+				// joined by stop()
+				_thread = std::thread(&LibraryWriter::run, this);
+			}
+
+			_cv.notify_all();
+		}
+
+		void appendLines(const std::string &filename, const std::vector<std::string> &lines) {
+			if (lines.empty()) return;
+
+			PM_TRACE_ZONE(zone, "LibraryWriter::appendLines");
+			PM_TRACE_OBJECTS(zone, lines.size());
 
-	ListingExParams() {}
+			std::ofstream journal(filename, std::ios::binary | std::ios::app);
+
+			for (const std::string &line : lines) {
+				journal << line << '\n';
+			}
+
+			journal.flush();
+
+			if (!journal.good()) {
+				log::error("LibraryWriter: could not append {} lines to {}", lines.size(), filename);
+			}
+		}
+
+		// hands a prepared file to the main thread and waits until it is in place
+		bool commit(std::shared_ptr<LibraryWriteState> state, const std::string &journal_path) {
+			{
+				std::lock_guard lock(_mutex);
+
+				_commit = std::move(state);
+				_commitJournalPath = journal_path;
+				_commitDone = false;
+
+				// flush() runs it itself instead of waiting for the next frame
+				_cv.notify_all();
+			}
+
+			Loader::get()->queueInMainThread([this]() {
+				runCommit();
+			});
+
+			std::unique_lock lock(_mutex);
+
+			_cv.wait(lock, [this] { return _commitDone; });
+
+			return _commitResult;
+		}
+
+		void run() {
+			std::unique_lock lock(_mutex);
+
+			while (true) {
+				_cv.wait(lock, [this] { return pending() || _stopping; });
+
+				// stop() flushes first, so there is nothing left to write here
+				if (!pending()) return;
+
+				while (!_flush) {
+					Clock::time_point deadline = std::min(_last + SAVE_DEBOUNCE, _first + SAVE_MAX_DELAY);
+
+					if (Clock::now() >= deadline) break;
+
+					_cv.wait_until(lock, deadline);
+				}
+
+				std::optional<ListingObject> snapshot = std::move(_snapshot);
+				std::vector<std::string> lines_before = std::move(_linesBefore);
+				std::vector<std::string> lines = std::move(_lines);
+				LibraryWriteOptions options = _options;
+				std::string library_path = _libraryPath;
+				std::string journal_path = _journalPath;
+
+				_snapshot.reset();
+				_linesBefore.clear();
+				_lines.clear();
+
+				_busy = true;
+
+				lock.unlock();
+
+				if (snapshot.has_value()) {
+					auto state = std::make_shared<LibraryWriteState>();
+
+					bool written = prepareLibrary(*state, library_path, *snapshot, options) && commit(state, journal_path);
+
+					// the old journal is still there, keep it complete
+					if (!written) appendLines(journal_path, lines_before);
+				}
+
+				appendLines(journal_path, lines);
+
+				lock.lock();
+
+				_stamp = LibraryStamp::of(library_path, journal_path);
+				_stamped = true;
+
+				_busy = false;
+				if (!pending()) _flush = false;
+
+				_cv.notify_all();
+			}
+		}
+	public:
+		void requestSnapshot(const ListingObject &tree, LibraryWriteOptions options) {
+			std::lock_guard lock(_mutex);
+
+			touch();
+
+			// folders are shared with `tree` until one of them is changed
+			_snapshot = tree;
+			_options = options;
+
+			_linesBefore.insert(_linesBefore.end(), std::make_move_iterator(_lines.begin()), std::make_move_iterator(_lines.end()));
+			_lines.clear();
+		}
+
+		void appendJournal(std::string line) {
+			std::lock_guard lock(_mutex);
+
+			touch();
+
+			_lines.push_back(std::move(line));
+		}
+
+		// puts a prepared file in place; main thread only
+		void runCommit() {
+			std::shared_ptr<LibraryWriteState> state;
+			std::string journal_path;
+
+			{
+				std::lock_guard lock(_mutex);
+
+				state = std::move(_commit);
+				_commit = nullptr;
+
+				journal_path = _commitJournalPath;
+			}
+
+			if (state == nullptr) return;
+
+			bool result = commitLibrary(*state);
+
+			if (result) {
+				std::error_code ec;
+				std::filesystem::remove(journal_path, ec);
+			}
+
+			std::lock_guard lock(_mutex);
+
+			_commitResult = result;
+			_commitDone = true;
+
+			_cv.notify_all();
+		}
+
+		// remembers the files as they are now, right before they are read
+		void stamp(const std::string &library_path, const std::string &journal_path) {
+			std::lock_guard lock(_mutex);
+
+			_stamp = LibraryStamp::of(library_path, journal_path);
+			_stamped = true;
+		}
+
+		/**
+		 * True if the files were changed by something else since we last wrote or read them.
+		 * While our own writes are queued the library in memory is the newest one, so this is false.
+		 */
+		bool changedOnDisk(const std::string &library_path, const std::string &journal_path) {
+			std::lock_guard lock(_mutex);
+
+			if (!_stamped) return true;
+			if (pending() || _busy || _commit != nullptr) return false;
+
+			return LibraryStamp::of(library_path, journal_path) != _stamp;
+		}
+
+		// writes everything queued so far; main thread only
+		void flush() {
+			PM_TRACE_ZONE(zone, "LibraryWriter::flush");
+
+			std::unique_lock lock(_mutex);
+
+			if (!_running) return;
+
+			_flush = true;
+			_cv.notify_all();
+
+			while (pending() || _busy) {
+				if (_commit != nullptr) {
+					lock.unlock();
+					runCommit();
+					lock.lock();
+
+					continue;
+				}
+
+				_cv.wait(lock);
+			}
+		}
+
+		/**
+		 * Writes everything queued so far and joins the writer thread; main thread only.
+		 * Anything queued afterwards starts a new thread.
+		 */
+		void stop() {
+			PM_TRACE_ZONE(zone, "LibraryWriter::stop");
+
+			flush();
+
+			{
+				std::lock_guard lock(_mutex);
+
+				if (!_running) return;
+
+				_stopping = true;
+				_cv.notify_all();
+			}
+
+			_thread.join();
+
+			std::lock_guard lock(_mutex);
+
+			_running = false;
+			_stopping = false;
+		}
+	};
+
+	/**
+	 * Never destroyed: stop() joins the thread when the game saves its data on exit,
+	 * but the writer has to stay usable for anything queued after that.
+	 */
+	LibraryWriter &libraryWriter = *new LibraryWriter();
+
+	// false until library.bin is known to exist or a snapshot of it is queued
+	bool libraryWritten = false;
+
+	// `root` holds the library from disk, see loadLibrary(); nothing is written while it does not
+	bool libraryLoaded = false;
+
+	// queues a full snapshot of the library, the journal is cleared once it is written
+	void save() {
+		// a library.bin that could not be read would be replaced by whatever is in memory
+		if (!libraryLoaded) {
+			log::error("save: the library is not loaded, not writing {}", getLibraryPath());
+
+			return;
+		}
+
+		LibraryWriteOptions options;
+		options.dedupLines = Mod::get()->getSettingValue<bool>("dedupe-object-lines");
+		options.compress = Mod::get()->getSettingValue<bool>("compress-library");
+
+		libraryWriter.requestSnapshot(root, options);
+
+		libraryWritten = true;
+		journalEntries = 0;
+	}
+
+	// root.json from older versions, only read when there is no library.bin yet
+	bool recoverLegacy() {
+		std::string filename = getRootPath();
+
+		if (!std::filesystem::exists(filename)) return false;
+
+		std::ifstream t(filename);
+		std::string str;
+
+		{
+			std::stringstream buffer;
+			buffer << t.rdbuf();
+
+			str = buffer.str();
+		}
+
+		t.close();
+
+		root = str;
+
+		log::info("recover: migrating {} to library.bin", filename);
+
+		return true;
+	}
 
-	operator nlohmann::json() {
-		nlohmann::json json;
+	void recover() {
+		PM_TRACE_ZONE(zone, "PMGlobal::recover");
 
-		json["c"] = _custom;
-		json["o"] = _origScale;
+		// the files have to be complete before they are read
+		libraryWriter.flush();
+		libraryWriter.stamp(getLibraryPath(), getJournalPath());
 
-		return json;
-	}
-	operator std::string() {
-		nlohmann::json json = *this;
+		bool migrate = false;
 
-		return json.dump();
-	}
+		// stays false if library.bin cannot be read, so it is not written over
+		libraryLoaded = false;
+		libraryWritten = std::filesystem::exists(getLibraryPath());
 
-	ListingExParams(std::string &json_string) {
-		nlohmann::json json = nlohmann::json::parse(json_string);
+		if (libraryWritten) {
+			ListingObject tree = ListingObject::Folder;
 
-		_custom = json["c"].get<bool>();
-		_origScale = json["o"].get<double>();
-	}
-};
+			// the file may have been replaced by something else, offsets into the old one are gone
+			ObjectPayload::currentGeneration++;
 
-class ListingObject {
-protected:
-#define RESTRICTED_UNIQUE_ID 0
-	int _uniqueID = RESTRICTED_UNIQUE_ID;
+			if (!readLibrary(getLibraryPath(), tree)) {
+				log::error("recover: could not read {}, nothing is saved until it is fixed or removed", getLibraryPath());
 
-	void setUniqueID() {
-		while (_uniqueID == RESTRICTED_UNIQUE_ID) {
-			_uniqueID = rand();
-		}
+				return;
+			}
 
-		log::debug("ListingObject::setUniqueID() = {}", _uniqueID);
-	}
-#undef RESTRICTED_UNIQUE_ID
-public:
-	enum ListingObjectType {
-		ObjectCollection,
-		Folder
-	};
+			root = std::move(tree);
+		} else {
+			migrate = recoverLegacy();
 
-	enum ListingObjectType _type = ObjectCollection;
-	std::string _name = "";
+			// nothing saved yet, the empty library in memory is current
+			if (!migrate) {
+				libraryLoaded = true;
 
-	std::vector<ListingObject> _folderContainer = {};
-	std::string _objectContainer = "";
-	
-	std::string _displayedName = "";
+				return;
+			}
+		}
 
-	bool _collectionSelected = false;
-	
-	bool _root = false;
+		journalEntries = 0;
 
-	std::string getObjectDefinition() const {
-		if (_type == ObjectCollection) return "Custom Object";
-		if (_type == Folder) return "Folder";
+		libraryIndex.rebuild(root);
 
-		return "Unknown Listing Object";
-	}
+		std::ifstream journal(getJournalPath());
+		std::string line;
 
-	ListingObject(const ListingObject &ref) {
-		// log::debug("copy constructor called with id={} ({})", ref.getUniqueID(), ref.getObjectDefinition());
+		while (std::getline(journal, line)) {
+			if (line.empty()) continue;
 
-		_uniqueID = ref.getUniqueID();
-		_type = ref._type;
-		_name = ref._name;
-		_folderContainer = ref._folderContainer;
-		_displayedName = ref._displayedName;
-		_collectionSelected = ref._collectionSelected;
-		_objectContainer = ref._objectContainer;
-		_root = ref._root;
-	}
+			nlohmann::json op = nlohmann::json::parse(line, nullptr, false);
 
-	ListingObject(enum ListingObjectType type) {
-		setUniqueID();
+			// the last line may be cut short by a crash
+			if (op.is_discarded() || !op.is_object()) {
+				log::warn("recover: skipping broken journal entry {}", journalEntries);
 
-		_type = type;
-		_name = "Unnamed " + std::to_string(getUniqueID());
-	}
-	ListingObject() {
-		setUniqueID();
-	}
+				break;
+			}
 
-	operator nlohmann::json() {
-		nlohmann::json json;
+			applyJournalOperation(root, op);
+			journalEntries++;
+		}
 
-		json["type"] = (int)_type;
-		json["name"] = _name;
+		log::debug("recover: replayed {} journal entries", journalEntries);
 
-		nlohmann::json folderContainer = nlohmann::json::array();
+		PM_TRACE_OBJECTS(zone, libraryIndex.size());
 
-		for (ListingObject &entry : _folderContainer) {
-			nlohmann::json obj = entry;
+		libraryLoaded = true;
 
-			folderContainer.push_back(obj);
+		if (migrate) {
+			save();
 		}
+	}
 
-		json["folderContainer"] = folderContainer;
-		json["objectContainer"] = _objectContainer;
+	// reads the library only the first time and when its files were changed by something else
+	void loadLibrary() {
+		PM_TRACE_ZONE(zone, "PMGlobal::loadLibrary");
 
-		json["uid"] = getUniqueID();
+		if (libraryLoaded && !libraryWriter.changedOnDisk(getLibraryPath(), getJournalPath())) return;
 
-		return json;
-	}
+		log::debug("loadLibrary: reading the library from disk");
 
-	operator std::string() {
-		nlohmann::json j = *this;
-		return j.dump(4);
+		recover();
 	}
 
-	ListingObject(std::string &json_string) {
-		nlohmann::json data = nlohmann::json::parse(json_string);
+	void appendJournal(const nlohmann::json &op) {
+		if (!libraryLoaded) {
+			log::error("appendJournal: the library is not loaded, dropping \"{}\"", op.value("op", ""));
 
-		if (data.contains("type") && data["type"].is_number()) {
-			_type = (enum ListingObjectType)(data["type"].get<int>());
-		}
-		if (data.contains("name") && data["name"].is_string()) {
-			_name = data["name"];
-		}
-		if (data.contains("objectContainer") && data["objectContainer"].is_string()) {
-			_objectContainer = data["objectContainer"];
+			return;
 		}
-		if (data.contains("folderContainer") && data["folderContainer"].is_array()) {
-			for (nlohmann::json &it : data["folderContainer"]) {
-				if (!it.is_object()) continue;
 
-				std::string val = it.dump();
-				_folderContainer.push_back(val);
-			}
+		// operations are only meaningful on top of a snapshot
+		if (!libraryWritten) {
+			save();
 		}
 
-		if (data.contains("uid") && data["uid"].is_number()) {
-			_uniqueID = data["uid"].get<int>();
-		} else {
-			setUniqueID();
-		}
-	}
+		libraryWriter.appendJournal(op.dump());
 
-	int getUniqueID() const {
-		return _uniqueID;
+		journalEntries++;
 	}
-};
 
-std::vector<GameObject *> _createObjectsFromColors();
+	void journalAdd(UniqueID parentUniqueID, ListingObject &entry) {
+		libraryIndex.add(parentUniqueID, entry);
 
-class ListingObjectInteractionPopup;
+		nlohmann::json op;
 
-namespace PMGlobal {
-	struct CollectionStructure {
-		int uniqueID;
-		CCPoint position;
-	};
+		op["op"] = "add";
+		op["parent"] = parentUniqueID;
+		op["entry"] = entry.toJson();
 
-	ListingObject root = ListingObject::Folder;
-	CCArray *selectedObjects = nullptr;
-	GJBaseGameLayer *baseGameLayer = nullptr;
-	std::string selectedObjectData = "";
-	int selectedUniqueID = 0;
-	bool triggerButtonActivation = false;
-	bool triggerButtonDisactivation = false;
-	int touchIndex = -502;
-	std::string _currentLevel;
-	ListingObjectInteractionPopup *instance = nullptr;
+		appendJournal(op);
+	}
+	void journalRemove(ListingObject &entry) {
+		libraryIndex.remove(entry);
 
-	std::array<gd::string, 595> tempArray1;
-	std::array<void *, 595> tempArray2;
+		nlohmann::json op;
 
-	std::vector<struct CollectionStructure> currentStructures;
+		op["op"] = "remove";
+		op["uid"] = entry.getUniqueID();
 
-	bool structureExists(int uniqueID, CCPoint pos) {
-		for (struct CollectionStructure &structure : currentStructures) {
-			if (structure.uniqueID == uniqueID && structure.position.x == pos.x && structure.position.y == pos.y) {
-				return true;
-			}
-		}
+		appendJournal(op);
+	}
+	void journalRename(UniqueID uniqueID, const std::string &name) {
+		nlohmann::json op;
+
+		op["op"] = "rename";
+		op["uid"] = uniqueID;
+		op["name"] = name;
 
-		return false;
+		appendJournal(op);
 	}
-	// bool hasStructureOnPosition(CCPoint pos) {
 
-	// }
-	std::vector<struct CollectionStructure> getStructuresOnPosition(CCPoint pos) {
-		std::vector<struct CollectionStructure> structures;
+	// folds the journal into a new library.bin once it gets long; `root` has to be up to date
+	void compactJournal() {
+		if (journalEntries < JOURNAL_COMPACT_ENTRIES) return;
 
-		for (struct CollectionStructure &structure : currentStructures) {
-			if (structure.position.x == pos.x && structure.position.y == pos.y) {
-				structures.push_back(structure);
-			}
-		}
+		log::debug("compactJournal: compacting {} entries", journalEntries);
 
-		return structures;
+		save();
 	}
 
-	void removeStructureFromList(struct CollectionStructure &collection) {
-		std::vector<struct CollectionStructure> new_vec;
+	/**
+	 * The editor selection is read straight from EditorUI instead of being mirrored by hooks.
+	 * A single selected object lives in `m_selectedObject`, several of them in `m_selectedObjects`.
+	 */
+	size_t selectedObjectCount() {
+		EditorUI *editorUI = EditorUI::get();
 
-		for (struct CollectionStructure &structure : currentStructures) {
-			if (structure.uniqueID == collection.uniqueID && structure.position.x == collection.position.x && structure.position.y == collection.position.y) {
-				continue;
-			}
+		if (editorUI == nullptr) return 0;
 
-			new_vec.push_back(structure);
+		if (editorUI->m_selectedObjects != nullptr && editorUI->m_selectedObjects->count() != 0) {
+			return editorUI->m_selectedObjects->count();
 		}
 
-		currentStructures = new_vec;
+		return editorUI->m_selectedObject != nullptr ? 1 : 0;
 	}
 
-	void save() {
-		std::string text = root;
+	template <typename F>
+	void forEachSelectedObject(F &&callback) {
+		EditorUI *editorUI = EditorUI::get();
 
-		std::string path = Mod::get()->getSaveDir().generic_string();
-		std::string filename = fmt::format("{}/root.json", path);
+		if (editorUI == nullptr) return;
 
-		std::ofstream o(filename);
+		if (editorUI->m_selectedObjects != nullptr && editorUI->m_selectedObjects->count() != 0) {
+			CCArray *objects = editorUI->m_selectedObjects;
 
-		o << text;
+			for (int i = 0; i < objects->count(); i++) {
+				GameObject *game_object = typeinfo_cast<GameObject *>(objects->objectAtIndex(i));
 
-		o.close();
+				if (game_object != nullptr) callback(game_object);
+			}
+		} else if (editorUI->m_selectedObject != nullptr) {
+			callback(editorUI->m_selectedObject);
+		}
 	}
-	void recover() {
-		std::string path = Mod::get()->getSaveDir().generic_string();
-		std::string filename = fmt::format("{}/root.json", path);
-
-		if (!std::filesystem::exists(filename)) return;
-
-		std::ifstream t(filename);
-		std::string str;
-
-		{
-			std::stringstream buffer;
-			buffer << t.rdbuf();
 
-			str = buffer.str();
-		}
+	CollectionTemplate selectedTemplate;
 
-		t.close();
+	void selectCollection(UniqueID uniqueID, std::string_view objects) {
+		selectedUniqueID = uniqueID;
+		selectedTemplate = CollectionTemplate(objects);
 
-		root = str;
+		log::debug("selectCollection: {} objects", selectedTemplate.size());
+	}
+	void clearSelectedCollection() {
+		selectedUniqueID = 0;
+		selectedTemplate = {};
 	}
 
-	void accessSelectedObjects() {
-		if (PMGlobal::selectedObjects == nullptr) {
-			PMGlobal::selectedObjects = CCArray::create();
-			PMGlobal::selectedObjects->retain();
-		}
+	size_t maxWorkers() {
+		return std::max(1u, std::thread::hardware_concurrency());
 	}
 
-	void crearArrayWithoutCleanup(CCArray *array) {
-		while (array->count() != 0) {
-			array->removeObjectAtIndex(0, false);
+	/**
+	 * Threads for runParallel(), started on first use and kept for the next calls.
+	 * The calling thread works on the job too; jobs from several threads run one after another.
+	 */
+	class WorkerPool {
+	private:
+		using Job = std::function<void(size_t, size_t, size_t)>;
+
+		// held for a whole job, so only one job uses the workers at a time
+		std::mutex _runMutex;
+
+		std::mutex _mutex;
+		// wakes the workers when a job starts or the pool stops
+		std::condition_variable _cv;
+		// wakes the caller once every chunk is done
+		std::condition_variable _done;
+
+		std::vector<std::thread> _threads = {};
+		bool _stopping = false;
+
+		const Job *_job = nullptr;
+		size_t _count = 0;
+		size_t _chunk = 0;
+		size_t _chunks = 0;
+		// next chunk to hand out and chunks that are not finished yet
+		size_t _next = 0;
+		size_t _pending = 0;
+
+		// runs chunks of the current job until none are left; `lock` holds _mutex
+		void work(std::unique_lock<std::mutex> &lock) {
+			while (_job != nullptr && _next < _chunks) {
+				const Job &job = *_job;
+				size_t index = _next++;
+				size_t begin = index * _chunk;
+
+				lock.unlock();
+				job(index, begin, std::min(_count, begin + _chunk));
+				lock.lock();
+
+				if (--_pending == 0) _done.notify_all();
+			}
 		}
-	}
 
-	std::vector<std::string> splitString(const char *str, char d, unsigned int max_entries = 0) {
-		std::vector<std::string> result;
+		void loop() {
+			std::unique_lock lock(_mutex);
 
-		do {
-			const char *begin = str;
+			while (true) {
+				_cv.wait(lock, [this] {
+					return _stopping || (_job != nullptr && _next < _chunks);
+				});
 
-			while(*str != d && *str) str++;
+				if (_stopping) return;
 
-			std::string _ready = {begin, str};
-			if (!_ready.empty()) {
-				result.push_back(_ready);
+				work(lock);
 			}
+		}
+	public:
+		// runs `job` over [0, count) split into `workers` contiguous chunks
+		void run(size_t workers, size_t count, const Job &job) {
+			std::lock_guard run_lock(_runMutex);
+			std::unique_lock lock(_mutex);
 
-			if (max_entries > 0 && result.size() > max_entries) {
-				break;
+			while (_threads.size() + 1 < workers) {
+				_threads.emplace_back(&WorkerPool::loop, this);
 			}
-		} while (0 != *str++);
 
-		int sz = result.size();
-		if (result[sz - 1].ends_with(fmt::format("{}", d))) {
-			result[sz - 1].pop_back();
-		}
+			_job = &job;
+			_count = count;
+			_chunk = (count + workers - 1) / workers;
+			_chunks = (count + _chunk - 1) / _chunk;
+			_next = 0;
+			_pending = _chunks;
 
-		return result;
-	}
+			_cv.notify_all();
 
-	std::map<int, std::string> parseObjectData(std::string &object_string, char delim = ',') {
-		std::vector<std::string> data = splitString(object_string.data(), delim);
+			work(lock);
 
-		std::map<int, std::string> object_map;
+			_done.wait(lock, [this] {
+				return _pending == 0;
+			});
 
-		bool _key = true;
+			_job = nullptr;
+		}
 
-		int key;
-		std::string value; 
+		// joins the threads; the next run() starts them again
+		void stop() {
+			std::lock_guard run_lock(_runMutex);
 
-		for (std::string el : data) {
-			if (_key) {
-				key = std::stoi(el);
-			} else {
-				value = el;
+			{
+				std::lock_guard lock(_mutex);
+
+				_stopping = true;
+				_cv.notify_all();
+			}
 
-				object_map[key] = value;
+			for (std::thread &thread : _threads) {
+				thread.join();
 			}
 
-			_key = !_key;
+			_threads.clear();
+			_stopping = false;
 		}
+	};
 
-		return object_map;
-	}
+	// never destroyed, like libraryWriter
+	WorkerPool &workerPool = *new WorkerPool();
 
-	CCPoint getPositionFromString(std::string &object_string) {
-		std::map<int, std::string> object_map = parseObjectData(object_string);
+	/**
+	 * Runs `job(chunk, begin, end)` over [0, count) split into contiguous chunks,
+	 * at most maxWorkers() of them. Returns after every chunk is done.
+	 */
+	void runParallel(size_t count, size_t min_chunk, const std::function<void(size_t, size_t, size_t)> &job) {
+		size_t workers = maxWorkers();
+		workers = std::min(workers, std::max<size_t>(1, count / std::max<size_t>(1, min_chunk)));
 
-		float x = std::stod(object_map[2]);
-		float y = std::stod(object_map[3]);
+		if (workers <= 1) {
+			job(0, 0, count);
 
-		CCPoint p = {x, y};
+			return;
+		}
 
-		return p;
+		workerPool.run(workers, count, job);
 	}
 
-	std::string buildKVString(std::map<int, std::string> &object_map) {
-		std::string res;
+	// everything a collection needs from the editor, taken on the main thread
+	struct SelectionSnapshot {
+		std::vector<std::string> objects = {};
+		std::vector<std::string> extra = {};
 
-		for (auto [k, v] : object_map) {
-			res += std::to_string(k) + "," + v + ",";
-		}
+		// moves objects so the bottom left one ends up at (0, 90)
+		CCPoint delta = {0.f, 0.f};
+	};
+
+	SelectionSnapshot snapshotSelection(bool copyLevelColors = false) {
+		SelectionSnapshot snapshot;
+
+		float min_x = std::numeric_limits<float>::max();
+		float min_y = std::numeric_limits<float>::max();
+
+		snapshot.objects.reserve(selectedObjectCount());
 
-		if (res.length() >= 1) {
-			res.pop_back();
+		forEachSelectedObject([&](GameObject *game_object) {
+			snapshot.objects.push_back(game_object->getSaveString(baseGameLayer));
+
+			min_x = std::min(min_x, game_object->getPositionX());
+			min_y = std::min(min_y, game_object->getPositionY());
+		});
+
+		if (snapshot.objects.empty()) return snapshot;
+
+		log::debug("min_x={}; min_y={}", min_x, min_y);
+
+		snapshot.delta = {-min_x, -(min_y - 90.f)};
+
+		if (copyLevelColors) {
+			snapshot.extra = _createObjectsFromColors();
 		}
 
-		return res;
+		return snapshot;
 	}
 
-	std::string setPositionToString(std::string &object_string, CCPoint pos) {
-		std::map<int, std::string> object_map = parseObjectData(object_string);
+	// moves and joins snapshot objects into a collection string; safe to call from any thread
+	std::string serializeSnapshot(const SelectionSnapshot &snapshot) {
+		const size_t count = snapshot.objects.size();
 
-		object_map[2] = std::to_string(pos.x);
-		object_map[3] = std::to_string(pos.y);
+		std::vector<std::string> chunks(maxWorkers());
 
-		return buildKVString(object_map);
-	}
+		runParallel(count, 256, [&](size_t chunk, size_t begin, size_t end) {
+			std::string &out = chunks[chunk];
 
-	GameObject *createGameObject(std::string &object_string) {
-		std::map<int, std::string> object_map = parseObjectData(object_string);
+			size_t size = 0;
+			for (size_t i = begin; i < end; i++) {
+				size += snapshot.objects[i].size() + 16;
+			}
 
-		tempArray1.fill("");
-		tempArray2.fill(nullptr);
+			out.reserve(size);
 
-		for (auto [k, v] : object_map) {
-			tempArray1[k] = v;
-			tempArray2[k] = baseGameLayer;
-		}
-#ifdef _WIN32
-		std::vector v1(tempArray1.begin(), tempArray1.end());
-		std::vector v2(tempArray2.begin(), tempArray2.end());
-#else
-		std::vector _v1(tempArray1.begin(), tempArray1.end());
-		std::vector _v2(tempArray2.begin(), tempArray2.end());
+			for (size_t i = begin; i < end; i++) {
+				if (i != begin) out += ';';
 
-		gd::vector v1(_v1);
-		gd::vector v2(_v2);
-#endif
+				appendMovedObject(out, snapshot.objects[i], snapshot.delta);
+			}
+		});
 
-		GameObject *new_object = GameObject::objectFromVector(
-			v1, v2, baseGameLayer, false
-		);
+		size_t size = 0;
+		for (const std::string &chunk : chunks) size += chunk.size() + 1;
+		for (const std::string &extra : snapshot.extra) size += extra.size() + 1;
 
-		return new_object;
-	}
+		std::string result;
+		result.reserve(size);
 
-	GameObject *copyGameObject(GameObject *_obj) {
-		if (!_obj) return nullptr;
+		for (const std::string &chunk : chunks) {
+			if (chunk.empty()) continue;
 
-		std::string object_string = _obj->getSaveString(baseGameLayer);
+			if (!result.empty()) result += ';';
+			result += chunk;
+		}
+		for (const std::string &extra : snapshot.extra) {
+			if (!result.empty()) result += ';';
+			result += extra;
+		}
 
-		return createGameObject(object_string);
+		return result;
 	}
 
-	std::vector<GameObject *> copyObjectsWithRelativePos(bool copyLevelColors = false) {
-		std::vector<GameObject *> result = {};
+	/**
+	 * Selected entries of a folder, one bit per entry.
+	 *
+	 * Also remembers the last two toggled entries so a range between them can be selected.
+	 */
+	class SelectionSet {
+	private:
+		std::vector<bool> _bits;
+		size_t _count = 0;
+
+		int _anchor = -1;
+		int _last = -1;
+	public:
+		void resize(size_t entries) {
+			if (entries < _bits.size()) {
+				for (size_t i = entries; i < _bits.size(); i++) {
+					if (_bits[i]) _count--;
+				}
+			}
+
+			_bits.resize(entries, false);
 
-		float min_x;
-		float min_y;
+			if (_anchor >= (int)entries) _anchor = -1;
+			if (_last >= (int)entries) _last = -1;
+		}
+
+		void clear() {
+			std::fill(_bits.begin(), _bits.end(), false);
+
+			_count = 0;
+			_anchor = -1;
+			_last = -1;
+		}
 
-		std::vector<float> x_vec;
-		std::vector<float> y_vec;
+		size_t size() const {
+			return _count;
+		}
 
-		accessSelectedObjects();
+		bool contains(int id) const {
+			return id >= 0 && id < (int)_bits.size() && _bits[id];
+		}
 
-		for (int i = 0; i < selectedObjects->count(); i++) {
-			CCObject *base_object = PMGlobal::selectedObjects->objectAtIndex(i);
-			GameObject *game_object = typeinfo_cast<GameObject *>(base_object);
+		bool insert(int id) {
+			if (id < 0 || contains(id)) return false;
 
-			if (game_object == nullptr) continue;	
+			if (id >= (int)_bits.size()) _bits.resize(id + 1, false);
 
-			GameObject *new_object = copyGameObject(game_object);
-			new_object->retain();
+			_bits[id] = true;
+			_count++;
 
-			result.push_back(new_object);
+			touch(id);
 
-			x_vec.push_back(game_object->getPositionX());
-			y_vec.push_back(game_object->getPositionY());
+			return true;
 		}
 
-		if (result.size() == 0) return result;
+		bool erase(int id) {
+			if (!contains(id)) return false;
 
-		min_x = *(std::min_element(x_vec.begin(), x_vec.end()));
-		min_y = *(std::min_element(y_vec.begin(), y_vec.end()));
+			_bits[id] = false;
+			_count--;
 
-		log::debug("min_x={}; min_y={}", min_x, min_y);
+			touch(id);
 
-		for (GameObject *ref : result) {
-			auto pos = ref->getPosition();
-			
-			pos.x -= min_x;
-			pos.y -= min_y - 90.f;
+			return true;
+		}
+
+		void touch(int id) {
+			if (id == _last) return;
 
-			ref->setPosition(pos);
+			_anchor = _last;
+			_last = id;
 		}
 
-		if (copyLevelColors) {
-			auto color_vec = _createObjectsFromColors();		
+		void selectAll() {
+			std::fill(_bits.begin(), _bits.end(), true);
 
-			result.insert(result.end(), color_vec.begin(), color_vec.end());
+			_count = _bits.size();
 		}
 
-		return result;
-	}
-}
+		void invert() {
+			_bits.flip();
 
-#include <functional>
+			_count = _bits.size() - _count;
+		}
 
-class ColorObject {
-private:
-	std::string _hsvObject = "";
+		bool hasRange() const {
+			return _anchor >= 0 && _last >= 0;
+		}
 
-	_ccColor3B _color = {};
-	_ccColor3B _color2 = {};
-	
-	bool _hueEnabled = false;
-	bool _blending = false;
-	bool _copyOpacity = false;
-	bool _legacyHue = false;
+		// selects everything between the last two toggled entries
+		void selectRange() {
+			if (!hasRange()) return;
 
-	int _target = 0;
-	int _copyTarget = 0;
-	int _unk00 = 1;
-	int _unk01 = 0;
+			int from = std::min(_anchor, _last);
+			int to = std::max(_anchor, _last);
 
-	float _opacity = 1.f;
+			for (int i = from; i <= to; i++) {
+				if (!_bits[i]) {
+					_bits[i] = true;
+					_count++;
+				}
+			}
+		}
 
-	int getHueEnabled() {
-		if (_hueEnabled) return 1;
+		// first selected entry, -1 if there is none
+		int first() const {
+			for (size_t i = 0; i < _bits.size(); i++) {
+				if (_bits[i]) return i;
+			}
 
-		return -1;
-	}
-	bool hueEnabled() {
-		return _hueEnabled || !_hsvObject.empty();
-	}
-public:
-	ColorObject() {}
+			return -1;
+		}
 
-	/**
-	 * key 1 - r
-	 * key 2 - g
-	 * key 3 - b
-	 * key 4 - hue enabled (-1 on disabled)
-	 * key 5 - blending
-	 * key 6 - color id
-	 * key 7 - opacity
-	 * key 8 - legacy hue enabled
-	 * key 9 - copied color id
-	 * key 10 - hue map (hue, sat, br, sat rel, br rel)
-	 * key 11 - ? (its always 255)
-	 * key 12 - ? (its always 255)
-	 * key 13 - ? (its always 255)
-	 * key 15 - ? (its always 1)
-	 * key 17 - copy opacity
-	 * key 18 - ? (its always 0) 
-	 */
-	ColorObject(std::string &v) {
-		log::debug("ColorObject: v = {}", v);
+		std::vector<int> indices() const {
+			std::vector<int> result;
+			result.reserve(_count);
+
+			for (size_t i = 0; i < _bits.size(); i++) {
+				if (_bits[i]) result.push_back(i);
+			}
 
-		std::map<int, std::string> kv_array = PMGlobal::parseObjectData(v, '_');
+			return result;
+		}
+	};
+}
 
-		if (kv_array.count(1)) _color.r = std::stoi(kv_array[1]);
-		if (kv_array.count(2)) _color.g = std::stoi(kv_array[2]);
-		if (kv_array.count(3)) _color.b = std::stoi(kv_array[3]);
+#include <functional>
 
-		if (kv_array.count(4)) {
-			int _v = std::stoi(kv_array[4]);
+namespace PMGlobal {
+	// colors of the level being edited, kept for the editor session
+	std::vector<ColorObject> levelColors;
+	bool levelColorsValid = false;
 
-			if (_v == -1) {
-				_hueEnabled = false;
-			} else {
-				_hueEnabled = true;
-			}
-		} else {
-			_hueEnabled = true;
-		}
-
-		if (kv_array.count(5)) _blending = std::stoi(kv_array[5]);
-		if (kv_array.count(8)) _legacyHue = std::stoi(kv_array[8]);
-		if (kv_array.count(17)) _copyOpacity = std::stoi(kv_array[17]);
-
-		if (kv_array.count(6)) _target = std::stoi(kv_array[6]);
-		if (kv_array.count(9)) _copyTarget = std::stoi(kv_array[9]);
-		if (kv_array.count(15)) _unk00 = std::stoi(kv_array[15]);
-		if (kv_array.count(18)) _unk01 = std::stoi(kv_array[18]);
-
-		if (kv_array.count(7)) _opacity = std::stof(kv_array[7]);
-
-		if (kv_array.count(10)) _hsvObject = kv_array[10];
-
-		if (kv_array.count(11)) _color2.r = std::stoi(kv_array[11]);
-		if (kv_array.count(12)) _color2.g = std::stoi(kv_array[12]);
-		if (kv_array.count(13)) _color2.b = std::stoi(kv_array[13]);
-	}
-	ColorObject(const ColorObject &ref) {
-		_hsvObject = ref._hsvObject;
-		_color = ref._color;
-		_color2 = ref._color2;
-		_hueEnabled = ref._hueEnabled;
-		_blending = ref._blending;
-		_copyOpacity = ref._copyOpacity;
-		_legacyHue = ref._legacyHue;
-		_target = ref._target;
-		_copyTarget = ref._copyTarget;
-		_unk00 = ref._unk00;
-		_unk01 = ref._unk01;
-		_opacity = ref._opacity;
-	}
-
-	// operator std::string() {
-	// 	return fmt::format("1_{}_2_{}_3_{}_4_{}_5_{}_6_{}_7_{}_8_{}_9_{}_10_{}_11_{}_12_{}_13_{}_15_{}_17_{}_18_{}",
-	// 		_color.r, _color.g, _color.b, 
-	// 		getHueEnabled(),
-	// 		(int)_blending,
-	// 		_target,
-	// 		_opacity,
-	// 		(int)_legacyHue,
-	// 		_copyTarget,
-	// 		_hsvObject,
-	// 		_color2.r, _color2.g, _color2.b,
-	// 		_unk00,
-	// 		(int)_copyOpacity,
-	// 		_unk01
-	// 	);
-	// }
+	void invalidateLevelColors() {
+		levelColors.clear();
+		levelColorsValid = false;
 
-	void debug() {
-		log::debug("ColorObject::debug: hue enabled: {}; hsv: {}; id={};", hueEnabled(), _hsvObject, _target);
+		_currentLevelHeader.clear();
 	}
 
-	std::string toTrigger(CCPoint pos) {
-		std::string str = fmt::format("1,899,2,{},3,{},7,{},8,{},9,{},10,0.1,17,{},23,{},20,100,35,{}",
-			pos.x, pos.y,
-			_color.r, _color.g, _color.b,
-			(int)_blending,
-			_target,
-			_opacity
-		);
+	/**
+	 * Reads the start object colors from the level settings, so no object is serialized.
+	 * They are parsed again only when the settings string changes.
+	 */
+	const std::vector<ColorObject> &getLevelColors() {
+		LevelEditorLayer *lel = typeinfo_cast<LevelEditorLayer *>(baseGameLayer);
 
-		if (_hueEnabled || !_hsvObject.empty()) {
-			str += fmt::format(",49,{},41,{}",
-				_hsvObject,
-				(int)_hueEnabled
-			);
-		}
+		if (lel == nullptr || lel->m_levelSettings == nullptr) {
+			invalidateLevelColors();
 
-		if (_copyTarget != 0) {
-			str += fmt::format(",50,{}",
-				_copyTarget
-			);
-		}
-		if (_copyOpacity) {
-			str += ",60,1";
+			return levelColors;
 		}
 
-		return str;
-	}
-};
+		std::string header = lel->m_levelSettings->getSaveString();
 
-class LevelStartObject {
-private:
-	std::vector<ColorObject> _colorObjects = {};
-public:
-	LevelStartObject(std::string &v) {
-		std::vector<std::string> cv = {};
+		if (levelColorsValid && header == _currentLevelHeader) return levelColors;
 
-		{
-			std::vector<std::string> _p = PMGlobal::splitString(v.c_str(), ',', 3);
+		log::debug("getLevelColors: level settings changed, parsing {} bytes", header.size());
 
-			if (_p.size() < 2) return;
+		LevelStartObject obj(header);
 
-			cv = PMGlobal::splitString(_p[1].c_str(), '|');
-		}
+		levelColors = std::move(obj.getColorObjects());
+		levelColorsValid = true;
 
-		for (std::string &ref : cv) {
-			_colorObjects.push_back(ref);
-		}
-	}
+		_currentLevelHeader = std::move(header);
 
-	std::vector<ColorObject> &getColorObjects() {
-		return _colorObjects;
+		return levelColors;
 	}
-};
-
-std::vector<GameObject *> _createObjectsFromColors() {
-	std::vector<GameObject *> result;
+}
 
-	LevelEditorLayer *lel = typeinfo_cast<LevelEditorLayer *>(PMGlobal::baseGameLayer);
-	PMGlobal::_currentLevel = lel->getLevelString();
-	// log::debug("{}\n------------", PMGlobal::_currentLevel);
+std::vector<std::string> _createObjectsFromColors() {
+	std::vector<std::string> result;
 
-	LevelStartObject obj = PMGlobal::_currentLevel;
-	auto vec = obj.getColorObjects();
+	std::vector<ColorObject> vec = PMGlobal::getLevelColors();
 
 	int offset = 0;
 
 	for (ColorObject &col_ref : vec) {
-		ColorObject copy(col_ref);
-		copy.debug();
-		
-		std::string generatedTrigger = copy.toTrigger({-90.f, (float)offset});
-
-		offset += 30;
+		col_ref.debug();
 
-		auto gameObject = PMGlobal::createGameObject(generatedTrigger);
-		gameObject->retain();
+		result.push_back(col_ref.toTrigger({-90.f, (float)offset}));
 
-		result.push_back(gameObject);
+		offset += 30;
 	}
 
 	return result;
@@ -859,6 +1962,15 @@ private:
 	CCMenu *_folderItems;
 	CCMenu *_actionItems;
 
+	// only one page of entries has buttons, they are reused when the page changes
+	static constexpr int ENTRIES_PER_PAGE = 24;
+
+	std::vector<CCMenuItemSpriteExtra *> _entryButtons;
+	int _page = 0;
+
+	CCMenu *_pageControls = nullptr;
+	CCLabelBMFont *_pageLabel = nullptr;
+
 	CustomObjectListingPopup *_parentPopup = nullptr;
 	int _entryID = 0;
 
@@ -866,7 +1978,10 @@ private:
 
 	std::function<void(CustomObjectListingPopup *)> _onRootModify = nullptr;
 
-	std::vector<int> _selectedEntries = {};
+	PMGlobal::SelectionSet _selectedEntries;
+
+	// names used in this folder; duplicates can still come from imports, so it is a multiset
+	std::unordered_multiset<std::string> _names;
 
 	bool _rootEntry = false;
 
@@ -875,16 +1990,39 @@ private:
 
 	std::vector<ListingObject> _entriesToExport;
 
-	bool tNotRestrited(int v, std::vector<int> restricted) {
-		for (int _v : restricted) {
-			if (_v == v) return false;
+	bool entrySelected(int id) {
+		return _selectedEntries.contains(id);
+	}
+
+	void rebuildNames() {
+		_names.clear();
+		_names.reserve(_root._folderContainer.size());
+
+		for (const ListingObject &entry : std::as_const(_root._folderContainer)) {
+			_names.insert(entry._name);
 		}
+	}
+	void removeName(const std::string &name) {
+		auto it = _names.find(name);
 
-		return true;
+		if (it != _names.end()) _names.erase(it);
 	}
 
-	bool entrySelected(int id) {
-		return !tNotRestrited(id, _selectedEntries);
+	void retainChain() {
+		for (CustomObjectListingPopup *popup = this; popup != nullptr; popup = popup->_parentPopup) {
+			popup->retain();
+		}
+	}
+	void releaseChain() {
+		std::vector<CustomObjectListingPopup *> chain;
+
+		for (CustomObjectListingPopup *popup = this; popup != nullptr; popup = popup->_parentPopup) {
+			chain.push_back(popup);
+		}
+
+		for (CustomObjectListingPopup *popup : chain) {
+			popup->release();
+		}
 	}
 
 	void callCallback() {
@@ -901,29 +2039,77 @@ private:
 		BFolderEmpty
 	};
 
-	void rebuildFolderListing() {
-		_folderItems->removeAllChildrenWithCleanup(true);
+	int getPageCount() {
+		return std::max<int>(1, (_root._folderContainer.size() + ENTRIES_PER_PAGE - 1) / ENTRIES_PER_PAGE);
+	}
+
+	// points the entry buttons at the current page, the caller updates the layout
+	void fillPage() {
+		_selectedEntries.resize(_root._folderContainer.size());
 
-		log::debug("rebuildFolderListing: rebuilding _folderItems");
+		_page = std::clamp(_page, 0, getPageCount() - 1);
 
-		int entry_index = 0;
+		size_t begin = (size_t)_page * ENTRIES_PER_PAGE;
+		size_t end = std::min(begin + ENTRIES_PER_PAGE, _root._folderContainer.size());
+		size_t used = 0;
 
-		for (ListingObject &folder_entry : _root._folderContainer) {	
-			auto entry_btn = addGuiObject(folder_entry);
+		for (size_t i = begin; i < end; i++) {
+			if (used == _entryButtons.size()) {
+				CCMenuItemSpriteExtra *entry_btn = createEntryButton();
+
+				_entryButtons.push_back(entry_btn);
+				_folderItems->addChild(entry_btn);
+			}
 
-			entry_index++;
-			if (entry_btn == nullptr) continue;
+			if (setupEntryButton(_entryButtons[used], std::as_const(_root._folderContainer)[i], i)) {
+				used++;
+			}
+		}
 
-			entry_btn->setTag(entry_index - 1);
+		for (size_t i = used; i < _entryButtons.size(); i++) {
+			_entryButtons[i]->setVisible(false);
+			_entryButtons[i]->setTag(-1);
 		}
+
+		updatePageControls();
 	}
 
-	bool rootHasUniqueID(int uid) {
-		for (ListingObject &obj : _root._folderContainer) {
-			if (obj.getUniqueID() == uid) return true;
-		}
+	void rebuildFolderListing() {
+		PM_TRACE_ZONE(zone, "rebuildFolderListing");
+		PM_TRACE_OBJECTS(zone, _root._folderContainer.size());
+
+		log::debug("rebuildFolderListing: showing page {} of _folderItems", _page);
+
+		fillPage();
+
+		_folderItems->updateLayout();
+
+		updateButtons();
+	}
+
+	void updatePageControls() {
+		if (_pageControls == nullptr) return;
 
-		return false;
+		int pages = getPageCount();
+
+		_pageControls->setVisible(pages > 1);
+		_pageLabel->setVisible(pages > 1);
+		_pageLabel->setString(fmt::format("{}/{}", _page + 1, pages).c_str());
+	}
+
+	void onPrevPage(CCObject *sender) {
+		if (_page == 0) return;
+
+		_page--;
+
+		rebuildFolderListing();
+	}
+	void onNextPage(CCObject *sender) {
+		if (_page + 1 >= getPageCount()) return;
+
+		_page++;
+
+		rebuildFolderListing();
 	}
 
 	CCNode *findItem(int id) {
@@ -942,13 +2128,11 @@ private:
 		}
 
 		if (_selectingItems) {
-			if (entrySelected(id)) {
+			if (!_selectedEntries.insert(id)) {
 				log::debug("selectItem: item {} is selected", id);
 
 				return;
 			}
-
-			_selectedEntries.push_back(id);
 		}
 
 		if (!findItem(id)) {
@@ -957,17 +2141,7 @@ private:
 			return;
 		}
 
-		CCSprite *spr = typeinfo_cast<CCSprite *>(findItem(id)->getChildByID("entry-sprite"));
-		if (!spr) {
-			log::debug("selectItem: could not find sprite inside item {}", id);
-
-			return;
-		}
-
-		float scale = 1.f;
-
-		spr->runAction(CCEaseExponentialOut::create(CCScaleTo::create(0.25, scale)));
-		spr->runAction(CCTintTo::create(0.25f, 255, 255, 255));
+		updateItemSprite(findItem(id), true);
 	}
 	void unselectItem(int id) {
 		if (id < 0) {
@@ -977,20 +2151,11 @@ private:
 		}
 
 		if (_selectingItems) {
-			if (!entrySelected(id)) {
+			if (!_selectedEntries.erase(id)) {
 				log::debug("unselectItem: item {} is not selected", id);
 
 				return;
 			}
-
-			std::vector<int> new_v;
-			for (int v : _selectedEntries) {
-				if (v == id) continue;
-
-				new_v.push_back(v);
-			}
-
-			_selectedEntries = new_v;
 		}
 
 		if (!findItem(id)) {
@@ -999,53 +2164,46 @@ private:
 			return;
 		}
 
-		CCSprite *spr = typeinfo_cast<CCSprite *>(findItem(id)->getChildByID("entry-sprite"));
-		if (!spr) {
-			log::debug("unselectItem: could not find sprite inside item {}", id);
-
-			return;
-		}
-
-		float scale = 0.5f;
-
-		spr->runAction(CCEaseExponentialOut::create(CCScaleTo::create(0.25, scale)));
-		spr->runAction(CCTintTo::create(0.25f, 128, 128, 128));
+		updateItemSprite(findItem(id), false);
 	}
 
-	void unselectItems() {
-		CCArray *children = _folderItems->getChildren();
-
-		if (children == nullptr) return;
+	void updateItemSprite(CCNode *item, bool selected, bool animate = true) {
+		CCSprite *spr = typeinfo_cast<CCSprite *>(item->getChildByID("entry-sprite"));
+		if (!spr) {
+			log::debug("updateItemSprite: could not find sprite inside item {}", item->getTag());
 
-		for (int i = 0; i < children->count(); i++) {
-			CCObject *entry = children->objectAtIndex(i);
-			int tag = -1;
+			return;
+		}
 
-			if (entry != nullptr) {
-				tag = entry->getTag();
-			}
+		float scale = selected ? 1.f : 0.5f;
+		GLubyte tint = selected ? 255 : 128;
 
-			log::debug("i={}; tag={}", i, tag);
+		spr->stopAllActions();
 
-			unselectItem(tag);
+		if (animate) {
+			spr->runAction(CCEaseExponentialOut::create(CCScaleTo::create(0.25, scale)));
+			spr->runAction(CCTintTo::create(0.25f, tint, tint, tint));
+		} else {
+			spr->setScale(scale);
+			spr->setColor({tint, tint, tint});
 		}
 	}
-	void selectItems() {
+
+	// brings every item sprite in line with the selection in one pass
+	void updateItemSprites() {
 		CCArray *children = _folderItems->getChildren();
 
-		for (int i = 0; i < children->count(); i++) {
-			CCObject *entry = children->objectAtIndex(i);
-			int tag = -1;
+		if (children == nullptr) return;
 
-			if (entry != nullptr) {
-				tag = entry->getTag();
-			}
+		for (int i = 0; i < children->count(); i++) {
+			CCNode *item = typeinfo_cast<CCNode *>(children->objectAtIndex(i));
 
-			log::debug("i={}; tag={}", i, tag);
+			if (item == nullptr || !item->isVisible()) continue;
 
-			selectItem(tag);
+			updateItemSprite(item, !_selectingItems || entrySelected(item->getTag()));
 		}
 	}
+
 public:
 	// void keyBackClicked() override {
 
@@ -1054,45 +2212,55 @@ public:
 	// }
 
 	void onObjectRename(CCObject *sender) {
-		if (!findItem(_selectedEntries[0])) {
-			log::debug("onObjectRename: _selectedEntries[0] does not exist");
+		int selected = _selectedEntries.first();
+
+		if (selected < 0 || selected >= (int)_root._folderContainer.size()) {
+			log::debug("onObjectRename: selected entry does not exist");
 
 			return;
 		}
 
-		ListingObject *refs = _root._folderContainer.data();
-
-		ListingObject *_object = refs + _selectedEntries[0];
-		ListingObject *object = new ListingObject(_object->_type);
-		object->_name = _object->_name;
+		const ListingObject &_object = std::as_const(_root._folderContainer)[selected];
+		ListingObject *object = new ListingObject(_object._type);
+		object->_name = _object._name;
 
 		std::string _oldName = object->_name;
 
 		ListingObjectInteractionPopup *popup = ListingObjectInteractionPopup::create(object, ListingObjectInteractionPopup::Rename);
 	
-		popup->setCallback([this, _oldName, object, _object](ListingObjectInteractionPopup *popup) {
+		// the folder can be shared or copied until the popup closes, so the entry is looked up again
+		popup->setCallback([this, _oldName, object, selected](ListingObjectInteractionPopup *popup) {
 			log::debug("renaming done!");
 			log::debug("new name: {}", object->_name);
 			log::debug("old name: {}", _oldName);
 
-			if (object->_name == _oldName) return;
+			if (object->_name == _oldName) {
+				delete object;
 
-			_object->_name = object->_name;
+				return;
+			}
 
-			delete object;
+			if (_names.contains(object->_name)) {
+				std::string desc = fmt::format("<cy>{} name</c> should be <cp>unique</c>!", object->getObjectDefinition());
 
-			for (ListingObject &folder_entry : _root._folderContainer) {
-				if (folder_entry._name == object->_name) {
-					std::string desc = fmt::format("<cy>{} name</c> should be <cp>unique</c>!", object->getObjectDefinition());
+				FLAlertLayer::create("Error", desc, "OK")->show();
 
-					FLAlertLayer::create("Error", desc, "OK")->show();
-					
-					object->_name = _oldName;
+				delete object;
 
-					return;
-				}
+				return;
 			}
 
+			ListingObject *_object = _root._folderContainer.data() + selected;
+
+			removeName(_object->_name);
+			_names.insert(object->_name);
+
+			_object->_name = object->_name;
+
+			delete object;
+
+			PMGlobal::journalRename(_object->getUniqueID(), _object->_name);
+
 			this->updateRootRecursive();
 			this->callCallback();
 
@@ -1108,61 +2276,64 @@ public:
 	}
 
 	void onDeleteItems(CCObject *sender) {
-		for (int j = 0; j < 1; j++) {
-			std::vector<int> uniques;
+		std::vector<ListingObject> new_container;
+		new_container.reserve(_root._folderContainer.size() - _selectedEntries.size());
 
-			auto selectedEntries = _selectedEntries;
+		for (size_t i = 0; i < _root._folderContainer.size(); i++) {
+			ListingObject &entry = _root._folderContainer[i];
 
-			for (int i : selectedEntries) {
-				unselectItem(i);
+			if (!entrySelected(i)) {
+				new_container.push_back(std::move(entry));
 
-				int id = _root._folderContainer[i].getUniqueID();
+				continue;
+			}
 
-				if (id == PMGlobal::selectedUniqueID) {
-					PMGlobal::selectedUniqueID = 0;
-					PMGlobal::selectedObjectData = "";
-				}
+			log::debug("onDeleteItems: removing {} ({})", i, entry.getUniqueID());
 
-				uniques.push_back(id);
+			if (entry.getUniqueID() == PMGlobal::selectedUniqueID) {
+				PMGlobal::clearSelectedCollection();
 			}
 
-			for (int i : uniques) {
-				log::debug("unique = {}", i);
-			}
-			for (int i : _selectedEntries) {
-				log::debug("entry = {}", i);
-			}
+			removeName(entry._name);
 
-			_folderItems->updateLayout();
+			PMGlobal::journalRemove(entry);
+		}
 
-			std::vector<ListingObject> new_container;
+		_root._folderContainer = std::move(new_container);
 
-			log::debug("onDeleteItems: _root._folderContainer");
+		_selectedEntries.clear();
 
-			for (auto &entry : _root._folderContainer) {
-				if (tNotRestrited(entry.getUniqueID(), uniques)) {
-					new_container.push_back(entry);
-				}
-			}
+		updateRootRecursive();
+		callCallback();
 
-			_root._folderContainer = new_container;
+		rebuildFolderListing();
+	}
 
-			updateRootRecursive();
-			callCallback();
+	void onSelectAll(CCObject *sender) {
+		_selectedEntries.resize(_root._folderContainer.size());
+		_selectedEntries.selectAll();
 
-			rebuildFolderListing();
+		updateItemSprites();
+		updateButtonsSelect();
+	}
+	void onSelectInvert(CCObject *sender) {
+		_selectedEntries.resize(_root._folderContainer.size());
+		_selectedEntries.invert();
 
-			_selectedEntries.clear();	
-		}
+		updateItemSprites();
+		updateButtonsSelect();
+	}
+	void onSelectRange(CCObject *sender) {
+		_selectedEntries.selectRange();
 
+		updateItemSprites();
 		updateButtonsSelect();
 	}
 
 	void onCreateCustomObject(CCObject *sender) {
 		if (PMGlobal::baseGameLayer == nullptr) return;
 
-		PMGlobal::accessSelectedObjects();
-		if (PMGlobal::selectedObjects->count() == 0) {
+		if (PMGlobal::selectedObjectCount() == 0) {
 			FLAlertLayer::create("Error", "You have <cy>to select some objects</c> to create a <cp>collection</c> of them.", "OK")->show();
 
 			return;
@@ -1175,17 +2346,18 @@ public:
 			log::debug("done!");
 
 			ListingObject *obj = popup->getObject();
-			
-			std::string serializedString = "";
 
-			std::vector<GameObject *> object_vec = PMGlobal::copyObjectsWithRelativePos(popup->shouldCopyLevelColors());
+			PM_TRACE_ZONE(zone, "onCreateCustomObject::snapshot");
 
-			for (GameObject *game_object : object_vec) {
-				serializedString += game_object->getSaveString(PMGlobal::baseGameLayer);
-				serializedString += ";";
-			}
+			// only the gd calls stay on the main thread, the rest is done by workers
+			auto snapshot = std::make_shared<PMGlobal::SelectionSnapshot>(
+				PMGlobal::snapshotSelection(popup->shouldCopyLevelColors())
+			);
+			size_t object_count = snapshot->objects.size();
+
+			PM_TRACE_OBJECTS(zone, object_count);
 
-			if (serializedString.empty()) {
+			if (object_count == 0) {
 				FLAlertLayer::create("Error", "Serialization process <cr>failed</c>: <cy>string is empty</c>.", "OK")->show();
 
 				delete obj;
@@ -1193,16 +2365,40 @@ public:
 				return;
 			}
 
-			if (serializedString.length() >= 1) {
-				serializedString.pop_back();
-			}
+			// popups have to stay alive until the collection is added to them
+			retainChain();
+
+			std::thread([this, obj, snapshot, object_count]() {
+				PM_TRACE_ZONE(zone, "onCreateCustomObject::serialize");
+				PM_TRACE_OBJECTS(zone, object_count);
 
-			obj->_objectContainer = serializedString;
+				auto time_start = std::chrono::steady_clock::now();
 
-			this->addObject(*obj);
-			delete obj;
+				std::string serializedString = PMGlobal::serializeSnapshot(*snapshot);
 
-			FLAlertLayer::create("Error", fmt::format("<cp>Object Collection</c> has been created out of <cy>{} objects</c>.", PMGlobal::selectedObjects->count()), "OK")->show();
+				PM_TRACE_BYTES(zone, serializedString.size());
+
+				double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+
+				Loader::get()->queueInMainThread([this, obj, object_count, elapsed, serializedString = std::move(serializedString)]() mutable {
+					log::info("onCreateCustomObject: serialized {} objects ({} bytes) in {:.2f} ms", object_count, serializedString.size(), elapsed);
+
+					if (serializedString.empty()) {
+						FLAlertLayer::create("Error", "Serialization process <cr>failed</c>: <cy>string is empty</c>.", "OK")->show();
+
+						delete obj;
+					} else {
+						obj->setObjectContainer(std::move(serializedString));
+
+						this->addObject(*obj);
+						delete obj;
+
+						FLAlertLayer::create("Error", fmt::format("<cp>Object Collection</c> has been created out of <cy>{} objects</c>.", object_count), "OK")->show();
+					}
+
+					releaseChain();
+				});
+			}).detach();
 		});
 	}
 
@@ -1221,31 +2417,23 @@ public:
 		_fileExportListener.setFilter(task);
 	}
 
-	void importEntries(std::vector<ListingObject> *entries, std::string path) {
-		if (!std::filesystem::exists(path)) return;
-
-		std::ifstream t(path);
-		std::string str;
-
-		{
-			std::stringstream buffer;
-			buffer << t.rdbuf();
+	// streams entries of an exported file to `onEntry`; returns false if the file is broken
+	bool importEntries(std::string path, const std::function<void(ListingObject &&)> &onEntry) {
+		if (!std::filesystem::exists(path)) return false;
 
-			str = buffer.str();
-		}
+		std::vector<char> buffer(1 << 16);
 
-		t.close();
+		std::ifstream t;
+		t.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+		t.open(path, std::ios::binary);
 
-		nlohmann::json json_array = nlohmann::json::parse(str);
-		if (!json_array.is_array()) return;
+		ListingObjectReader reader(onEntry);
 
-		for (nlohmann::json &ref : json_array) {
-			std::string ser = ref.dump();
+		bool result = nlohmann::json::sax_parse(t, &reader);
 
-			ListingObject obj = ser;
+		log::debug("importEntries: read {} entries from {}", reader._entries, path);
 
-			entries->push_back(obj);
-		}
+		return result;
 	}
 
 	void onExportComplete(Task<Result<std::filesystem::path>>::Event *event) {
@@ -1262,18 +2450,35 @@ public:
 
 			log::debug("filename_str={}", filename_str);
 
-			nlohmann::json json_array = nlohmann::json::array();
+			PM_TRACE_ZONE(zone, "onExportComplete");
+
+			bool compress = Mod::get()->getSettingValue<bool>("compress-exports");
+
+			std::vector<char> buffer(1 << 16);
 
-			for (ListingObject & obj : _entriesToExport) {
-				nlohmann::json jobj = obj;
+			std::ofstream out;
+			out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+			out.open(filename_str, std::ios::binary | std::ios::trunc);
 
-				json_array.push_back(jobj);
+			ListingObjectWriter writer(out, compress);
+
+			writer.begin();
+
+			for (const ListingObject &obj : _entriesToExport) {
+				writer.write(obj);
 			}
 
-			std::string data = json_array.dump();
+			writer.end();
+
+			out.flush();
+
+			PM_TRACE_OBJECTS(zone, writer.size());
+			PM_TRACE_BYTES(zone, out.tellp());
+
+			if (!out.good()) {
+				FLAlertLayer::create("Error", fmt::format("Could not write <cy>{}</c>.", filename_str), "OK")->show();
+			}
 
-			std::ofstream out(filename_str);
-			out << data;
 			out.close();
 
 			_entriesToExport.clear();
@@ -1291,20 +2496,41 @@ public:
 
 				log::debug("filename_str={}", filename_str);
 
-				std::vector<ListingObject> *objects = new std::vector<ListingObject>();
+				PM_TRACE_ZONE(zone, "onImportComplete");
 
-				importEntries(objects, filename_str);
+				// uid -> index of the entry in this folder
+				std::unordered_map<ListingObject::UniqueID, size_t> uniques;
 
-				for (auto it = objects->begin(); it != objects->end(); ++it) {
-					if (rootHasUniqueID(it->getUniqueID())) continue;
-
-					_root._folderContainer.push_back(*it);
+				for (size_t i = 0; i < _root._folderContainer.size(); i++) {
+					uniques.emplace(std::as_const(_root._folderContainer)[i].getUniqueID(), i);
 				}
 
+				importEntries(filename_str, [this, &uniques](ListingObject &&entry) {
+					auto it = uniques.find(entry.getUniqueID());
+
+					if (it != uniques.end()) {
+						// the same entry is already in this folder
+						if (PMGlobal::sameContent(std::as_const(_root._folderContainer)[it->second], entry)) return;
+
+						// older versions took uids from unseeded rand(), so different entries share them
+						entry.resetUniqueID();
+					}
+
+					// a copy of something that lives elsewhere in the library gets its own uids
+					PMGlobal::makeUniqueIDsFree(entry);
+
+					uniques.emplace(entry.getUniqueID(), _root._folderContainer.size());
+
+					PMGlobal::journalAdd(_root.getUniqueID(), entry);
+					_names.insert(entry._name);
+					_root._folderContainer.push_back(std::move(entry));
+				});
+
 				updateRootRecursive();
 				callCallback();
 
-				delete objects;
+				PM_TRACE_OBJECTS(zone, _root._folderContainer.size());
+				PM_TRACE_BYTES(zone, std::filesystem::exists(path) ? std::filesystem::file_size(path) : 0);
 			}
 			
 			rebuildFolderListing();
@@ -1315,19 +2541,33 @@ public:
 		std::vector<ListingObject> objects;
 
 		if (_selectingItems) {
-			for (int id : _selectedEntries) {
-				ListingObject &obj = _root._folderContainer[id];
+			for (int id : _selectedEntries.indices()) {
+				const ListingObject &obj = std::as_const(_root._folderContainer)[id];
 
 				objects.push_back(obj);
 			}
 		} else {
-			for (ListingObject &obj : _root._folderContainer) {
+			for (const ListingObject &obj : std::as_const(_root._folderContainer)) {
 				objects.push_back(obj);
 			}
 		}
 
 		exportEntries(objects);
 	}
+#ifdef BETTEROBJECTS_TRACING
+	// writes recorded trace zones to the save dir
+	void onDumpTrace(CCObject *sender) {
+		std::string directory = Mod::get()->getSaveDir().string();
+
+		if (!PMTrace::dump(directory)) {
+			FLAlertLayer::create("Error", "Could not write the <cy>trace</c>.", "OK")->show();
+
+			return;
+		}
+
+		FLAlertLayer::create("Trace", fmt::format("Trace has been written to <cy>{}</c>.", directory), "OK")->show();
+	}
+#endif
 	void onImport(CCObject *sender) {
 		struct utils::file::FilePickOptions options;
 
@@ -1387,6 +2627,22 @@ public:
 
 				actions->addChild(btn);
 			}
+
+#ifdef BETTEROBJECTS_TRACING
+			{
+				auto trace_spr = ButtonSprite::create("Trace");
+
+				trace_spr->setScale(0.5f);
+
+				auto btn = CCMenuItemSpriteExtra::create(
+					trace_spr,
+					this,
+					menu_selector(CustomObjectListingPopup::onDumpTrace)
+				);
+
+				actions->addChild(btn);
+			}
+#endif
 		}
 
 		if (type == BSelectZero || type == BSelectSingular || type == BSelectMutliple) {
@@ -1401,6 +2657,46 @@ public:
 					menu_selector(CustomObjectListingPopup::onSelect)
 				);
 
+				actions->addChild(btn);
+			}
+			{
+				auto all_spr = ButtonSprite::create("All");
+
+				all_spr->setScale(0.5f);
+
+				auto btn = CCMenuItemSpriteExtra::create(
+					all_spr,
+					this,
+					menu_selector(CustomObjectListingPopup::onSelectAll)
+				);
+
+				actions->addChild(btn);
+			}
+			{
+				auto invert_spr = ButtonSprite::create("Invert");
+
+				invert_spr->setScale(0.5f);
+
+				auto btn = CCMenuItemSpriteExtra::create(
+					invert_spr,
+					this,
+					menu_selector(CustomObjectListingPopup::onSelectInvert)
+				);
+
+				actions->addChild(btn);
+			}
+
+			if (_selectedEntries.hasRange()) {
+				auto range_spr = ButtonSprite::create("Range");
+
+				range_spr->setScale(0.5f);
+
+				auto btn = CCMenuItemSpriteExtra::create(
+					range_spr,
+					this,
+					menu_selector(CustomObjectListingPopup::onSelectRange)
+				);
+
 				actions->addChild(btn);
 			}
 		}
@@ -1470,7 +2766,7 @@ public:
 	void updateButtonsBase() {
 		_actionItems->removeAllChildrenWithCleanup(true);
 
-		if (_folderItems->getChildrenCount() != 0) {
+		if (!_root._folderContainer.empty()) {
 			setupButtons(CustomObjectListingPopup::BFolderBasic);
 		} else {
 			setupButtons(CustomObjectListingPopup::BFolderEmpty);
@@ -1492,6 +2788,13 @@ public:
 			setupButtons(CustomObjectListingPopup::BSelectMutliple);
 		}
 	}
+	void updateButtons() {
+		if (_selectingItems) {
+			updateButtonsSelect();
+		} else {
+			updateButtonsBase();
+		}
+	}
 
 	void setModifyCallback(std::function<void(CustomObjectListingPopup *)> onRootModify) {
 		_onRootModify = onRootModify;
@@ -1528,7 +2831,7 @@ public:
 			return;
 		}
 
-		ListingObject entry = _root._folderContainer[id];
+		ListingObject entry = std::as_const(_root._folderContainer)[id];
 
 		if (entry._type == entry.Folder) {
 			std::string entry_name = entry._name;
@@ -1555,8 +2858,9 @@ public:
 			}
 
 			if (entry_ptr->_collectionSelected) {
-				PMGlobal::selectedObjectData = entry_ptr->_objectContainer;
-				PMGlobal::selectedUniqueID = entry_ptr->getUniqueID();
+				entry_ptr->visitObjectContainer([&](std::string_view objects) {
+					PMGlobal::selectCollection(entry_ptr->getUniqueID(), objects);
+				});
 
 				// auto editorUI = EditorUI::get();
 				// editorUI->m_deselectBtn->setEnabled(true);
@@ -1567,8 +2871,7 @@ public:
 					spr->setColor({128, 128, 128});
 				}
 			} else {
-				PMGlobal::selectedObjectData = "";
-				PMGlobal::selectedUniqueID = 0;
+				PMGlobal::clearSelectedCollection();
 				// PMGlobal::triggerButtonDisactivation = true;
 
 				// auto editorUI = EditorUI::get();
@@ -1596,31 +2899,13 @@ public:
 		}
 	}
 
-	CCMenuItemSpriteExtra *addGuiObject(ListingObject &object, bool animate = false) {
-		CCSprite *spr = nullptr;
-		bool with_custom = false;
+	CCMenuItemSpriteExtra *createEntryButton() {
+		CCSprite *spr = CCSprite::createWithSpriteFrameName("square_01_001.png");
 
 		ListingExParams params;
+		std::string s = params;
 
-		if (object._type == object.Folder) {
-			spr = CCSprite::createWithSpriteFrameName("gj_folderBtn_001.png");
-		}
-		else if (object._type == object.ObjectCollection) {
-			spr = CCSprite::createWithSpriteFrameName("square_01_001.png");
-		}
-
-		if (spr != nullptr) {
-			std::string s = params;
-
-			spr->setUserObject(CCString::create(s.c_str()));
-		} else {
-			return nullptr;
-		}
-
-		if (object._type == object.ObjectCollection && object._collectionSelected) {
-			spr->setColor({128, 128, 128});
-		}
-
+		spr->setUserObject(CCString::create(s.c_str()));
 		spr->setID("entry-sprite");
 
 		auto entry_btn = CCMenuItemSpriteExtra::create(
@@ -1636,8 +2921,44 @@ public:
 
 		entry_btn->setLayout(entry_layout);
 
-		auto bmf = CCLabelBMFont::create(object._name.c_str(), "bigFont.fnt");
+		auto bmf = CCLabelBMFont::create("", "bigFont.fnt");
 		bmf->setScale(0.25f);
+		bmf->setID("entry-label");
+
+		entry_btn->addChild(bmf);
+
+		return entry_btn;
+	}
+
+	// shows entry `index` on a recycled button; returns false if the entry has no button
+	bool setupEntryButton(CCMenuItemSpriteExtra *entry_btn, const ListingObject &object, int index) {
+		const char *frame = nullptr;
+
+		if (object._type == object.Folder) {
+			frame = "gj_folderBtn_001.png";
+		}
+		else if (object._type == object.ObjectCollection) {
+			frame = "square_01_001.png";
+		}
+
+		if (frame == nullptr) return false;
+
+		CCSprite *spr = typeinfo_cast<CCSprite *>(entry_btn->getChildByID("entry-sprite"));
+		CCLabelBMFont *bmf = typeinfo_cast<CCLabelBMFont *>(entry_btn->getChildByID("entry-label"));
+
+		if (spr == nullptr || bmf == nullptr) return false;
+
+		spr->setDisplayFrame(CCSpriteFrameCache::sharedSpriteFrameCache()->spriteFrameByName(frame));
+		spr->stopAllActions();
+		spr->setScale(1.f);
+
+		if (object._type == object.ObjectCollection && object._collectionSelected) {
+			spr->setColor({128, 128, 128});
+		} else {
+			spr->setColor({255, 255, 255});
+		}
+
+		bmf->setString(object._name.c_str());
 
 		auto bmf_csz = bmf->getContentSize();
 		bmf_csz.width *= bmf->getScale();
@@ -1651,53 +2972,43 @@ public:
 		new_csz.width = max_width;
 		new_csz.height = bmf_csz.height;
 
-		entry_btn->addChild(bmf);
 		entry_btn->setContentSize(new_csz);
 		entry_btn->updateLayout();
 
-		_folderItems->addChild(entry_btn);
-		_folderItems->updateLayout();
+		entry_btn->setTag(index);
+		entry_btn->setVisible(true);
 
 		if (_selectingItems) {
-			int id = entry_btn->getTag();
-
-			if (!entrySelected(id)) {
-				selectItem(id);
-				unselectItem(id);
-			}
-
-			updateButtonsSelect();
-		} else {
-			updateButtonsBase();
+			updateItemSprite(entry_btn, entrySelected(index), false);
 		}
 
-		return entry_btn;
+		return true;
 	}
 
 	void addObject(ListingObject object) {
 		if (_root._type == _root.Folder) {
 			if (object._name.empty()) return;
 
-			for (ListingObject &folder_entry : _root._folderContainer) {
-				if (folder_entry._name == object._name) {
-					std::string desc = fmt::format("<cy>{} name</c> should be <cp>unique</c>!", object.getObjectDefinition());
+			if (_names.contains(object._name)) {
+				std::string desc = fmt::format("<cy>{} name</c> should be <cp>unique</c>!", object.getObjectDefinition());
 
-					FLAlertLayer::create("Error", desc, "OK")->show();
+				FLAlertLayer::create("Error", desc, "OK")->show();
 
-					return;
-				}
+				return;
 			}
 
 			_root._folderContainer.push_back(object);
+			_names.insert(object._name);
+			PMGlobal::journalAdd(_root.getUniqueID(), object);
+
 			callCallback();
 
 			updateRootRecursive();
 
-			auto btn = addGuiObject(object, true);
-
-			if (!btn) return;
+			// jump to the page with the new entry
+			_page = (_root._folderContainer.size() - 1) / ENTRIES_PER_PAGE;
 
-			btn->setTag(_root._folderContainer.size() - 1);
+			rebuildFolderListing();
 		}
 	}
 
@@ -1705,18 +3016,17 @@ public:
 		_actionItems->removeAllChildrenWithCleanup(true);
 
 		_selectedEntries.clear();
+		_selectedEntries.resize(_root._folderContainer.size());
 
 		_selectingItems = !_selectingItems;
 		if (_selectingItems) {
 			setupButtons(CustomObjectListingPopup::BSelectZero);
-			_selectingItems = false;
-			unselectItems();
-			_selectingItems = true;
 		} else {
 			setupButtons(CustomObjectListingPopup::BFolderBasic);
-			selectItems();
 		}
 
+		updateItemSprites();
+
 		_actionItems->updateLayout();
 	}
 	void onExitAll(CCObject *sender) {
@@ -1764,6 +3074,7 @@ private:
 		layout->setGrowCrossAxis(true);
 		layout->setGap(7.f);
 		layout->setCrossAxisOverflow(false);
+		layout->ignoreInvisibleChildren(true);
 
 		items->setLayout(layout);
 
@@ -1793,23 +3104,18 @@ private:
 
 		actions->setLayout(actions_layout);
 
-		int entry_index = 0;
+		rebuildNames();
 
-		for (ListingObject &folder_entry : listing._folderContainer) {
-			log::debug("{} vs {} : {}", PMGlobal::selectedUniqueID, folder_entry.getUniqueID(), PMGlobal::selectedUniqueID == folder_entry.getUniqueID());
+		for (size_t i = 0; i < _root._folderContainer.size(); i++) {
+			const ListingObject &folder_entry = std::as_const(_root._folderContainer)[i];
 
-			if (PMGlobal::selectedUniqueID == folder_entry.getUniqueID()) {
-				folder_entry._collectionSelected = true;
+			if (PMGlobal::selectedUniqueID == folder_entry.getUniqueID() && !folder_entry._collectionSelected) {
+				_root._folderContainer[i]._collectionSelected = true;
 			}
-
-			auto entry_btn = addGuiObject(folder_entry);
-
-			entry_index++;
-			if (entry_btn == nullptr) continue;
-
-			entry_btn->setTag(entry_index - 1);
 		}
 
+		fillPage();
+
 		items->updateLayout();
 		actions->updateLayout();
 		folder_layer->updateLayout();
@@ -1846,6 +3152,47 @@ private:
 
 		folder_layer->addChild(line1, 1);
 		folder_layer->addChild(line2, 0);
+
+		CCMenu *page_controls = CCMenu::create();
+		page_controls->setPosition(winsize / 2.f);
+
+		auto prev_spr = CCSprite::createWithSpriteFrameName("GJ_arrow_01_001.png");
+		prev_spr->setScale(0.6f);
+
+		auto prev_btn = CCMenuItemSpriteExtra::create(
+			prev_spr,
+			this,
+			menu_selector(CustomObjectListingPopup::onPrevPage)
+		);
+		prev_btn->setPositionX(-_spr1->getContentSize().width / 2.f - 20.f);
+
+		auto next_spr = CCSprite::createWithSpriteFrameName("GJ_arrow_01_001.png");
+		next_spr->setScale(0.6f);
+		next_spr->setFlipX(true);
+
+		auto next_btn = CCMenuItemSpriteExtra::create(
+			next_spr,
+			this,
+			menu_selector(CustomObjectListingPopup::onNextPage)
+		);
+		next_btn->setPositionX(_spr1->getContentSize().width / 2.f + 20.f);
+
+		page_controls->addChild(prev_btn);
+		page_controls->addChild(next_btn);
+
+		_objectSelector->addChild(page_controls, 20);
+
+		auto page_label = CCLabelBMFont::create("", "goldFont.fnt");
+		page_label->setScale(0.4f);
+		page_label->setPositionX(winsize.width / 2 + _spr1->getContentSize().width / 2 - 25);
+		page_label->setPositionY(winsize.height / 2 - _spr1->getContentSize().height / 2 + 12);
+
+		_objectSelector->addChild(page_label, 20);
+
+		_pageControls = page_controls;
+		_pageLabel = page_label;
+
+		updatePageControls();
 	}
 public:
 	static CustomObjectListingPopup *create(ListingObject &listing) {
@@ -1965,9 +3312,7 @@ class $modify(XLevelEditorLayer, LevelEditorLayer) {
 
 		PMGlobal::baseGameLayer = this;
 		PMGlobal::currentStructures.clear();
-		
-		PMGlobal::accessSelectedObjects();
-		PMGlobal::crearArrayWithoutCleanup(PMGlobal::selectedObjects);
+		PMGlobal::invalidateLevelColors();
 
 		EditorUI *eui = EditorUI::get();
 		CCMenu *undo = typeinfo_cast<CCMenu *>(eui->getChildByID("settings-menu"));
@@ -2010,7 +3355,13 @@ class $modify(XLevelEditorLayer, LevelEditorLayer) {
 	}
 
 	void onMyButton(CCObject*) {
-		PMGlobal::recover();
+		PMGlobal::loadLibrary();
+
+		if (!PMGlobal::libraryLoaded) {
+			FLAlertLayer::create("Error", "<cy>library.bin</c> could not be read. Nothing is saved until it is <cr>fixed or removed</c>.", "OK")->show();
+
+			return;
+		}
 
 		// PMGlobal::_currentLevel = getLevelString();
 		// // log::debug("{}\n------------", PMGlobal::_currentLevel);
@@ -2026,20 +3377,13 @@ class $modify(XLevelEditorLayer, LevelEditorLayer) {
 		auto popup = CustomObjectListingPopup::create(PMGlobal::root);
 
 		popup->setModifyCallback([](CustomObjectListingPopup *popup) {
+			// changes are already in the journal, library.bin is only rewritten once it gets long
 			PMGlobal::root = popup->getRoot();
 			PMGlobal::root._root = true; 
-			PMGlobal::save();
+			PMGlobal::compactJournal();
 
 			log::debug("modified!");
 		});
-		
-		// auto objects = PMGlobal::copyObjectsWithRelativePos();
-
-		// for (int i = 0; i < objects.size(); i++) {
-		// 	log::debug(" - {} -> {}", i, objects[i]->getSaveString(this));
-		// }
-		// PMGlobal::accessSelectedObjects();
-		// goThroughArray(PMGlobal::selectedObjects, "PMGlobal::selectedObjects");
 	}
 };
 
@@ -2052,62 +3396,25 @@ class $modify(XLevelEditorLayer, LevelEditorLayer) {
 // };
 
 class $modify(EditorUI) {
-	void selectObject(GameObject *obj, bool p1) {
-		// log::debug("hook! p1={}", p1);
-
-		EditorUI::selectObject(obj, p1);
-
-		PMGlobal::accessSelectedObjects();
-		PMGlobal::crearArrayWithoutCleanup(PMGlobal::selectedObjects);
-
-		if (m_selectedObjects->count() == 0) {
-			PMGlobal::selectedObjects->addObject(obj);
-		}
-	}
-
-	void selectObjects(CCArray *p0, bool p1) {
-		// log::debug("hook! p0={}; p1={}", p0->count(), p1);
-
-		EditorUI::selectObjects(p0, p1);
-		
-		PMGlobal::accessSelectedObjects();
-		PMGlobal::crearArrayWithoutCleanup(PMGlobal::selectedObjects);
-
-		PMGlobal::selectedObjects->addObjectsFromArray(m_selectedObjects);
-	}
-
-	void deselectAll() {
-		EditorUI::deselectAll();
-
-		PMGlobal::accessSelectedObjects();
-		PMGlobal::crearArrayWithoutCleanup(PMGlobal::selectedObjects);
-
-		// log::debug("EditorUI::deselectAll();");
-	}
-
 	void deselectObject(GameObject *p0) {
 		EditorUI::deselectObject(p0);
 
-		PMGlobal::accessSelectedObjects();
+		auto position = p0->getRealPosition();
+		auto structures = PMGlobal::getStructuresOnPosition(position);
 
-		if (PMGlobal::selectedObjects->containsObject(p0)) {
-			PMGlobal::selectedObjects->removeObject(p0, false);
-		}
-
-		// auto position = p0->getRealPosition();
-		// auto structures = PMGlobal::getStructuresOnPosition(position);
+		if (structures.size() != 0) {
+			log::debug("found {} structures", structures.size());
 
-		// log::debug("found {} structures", structures.size());
-
-		// if (structures.size() != 0) {
-		// 	for (struct PMGlobal::CollectionStructure &structure : structures) {
-		// 		PMGlobal::removeStructureFromList(structure);
-		// 	}
-		// }
+			for (struct PMGlobal::CollectionStructure &structure : structures) {
+				PMGlobal::removeStructureFromList(structure);
+			}
+		}
 		// log::debug("EditorUI::deselectObject({}); | Pos={}", p0, p0->getRealPosition());
 	}
 
 	void clickOnPosition(CCPoint p0) {
+		PM_TRACE_ZONE(zone, "EditorUI::clickOnPosition");
+
 		// if (PMGlobal::selectedObjectData.empty()) {
 		// 	return EditorUI::clickOnPosition(p0);
 		// }
@@ -2115,7 +3422,7 @@ class $modify(EditorUI) {
 
 		// log::debug("EditorUI::clickOnPosition({});\nselectedObjectData={}\nm_cameraTest={}\nm_clickAtPosition={}", p0, PMGlobal::selectedObjectData, m_cameraTest, m_clickAtPosition);
 
-		if (PMGlobal::selectedObjectData.empty()) return;
+		if (PMGlobal::selectedTemplate.empty()) return;
 
 		auto alignedPos = getGridSnappedPos(m_clickAtPosition);
 
@@ -2127,27 +3434,36 @@ class $modify(EditorUI) {
 			PMGlobal::selectedUniqueID,
 			base_offset
 		};
-		
-		PMGlobal::currentStructures.push_back(structure);
 
 		LevelEditorLayer *layer = typeinfo_cast<LevelEditorLayer *>(PMGlobal::baseGameLayer);
-		std::vector<std::string> earlyObjects = PMGlobal::splitString(PMGlobal::selectedObjectData.c_str(), ';');
 
-		CCArray *objectArray = CCArray::create();
-		objectArray->retain();
+		auto time_start = std::chrono::steady_clock::now();
+
+		std::string level_string;
+		PMGlobal::selectedTemplate.build(base_offset, level_string);
 
-		for (std::string _earlyObject : earlyObjects) {
-			CCPoint old_pos = PMGlobal::getPositionFromString(_earlyObject);
+		PM_TRACE_OBJECTS(zone, PMGlobal::selectedTemplate.size());
+		PM_TRACE_BYTES(zone, level_string.size());
 
-			old_pos.x += base_offset.x,
-			old_pos.y += base_offset.y;
+		auto time_built = std::chrono::steady_clock::now();
 
-			std::string new_data = PMGlobal::setPositionToString(_earlyObject, old_pos);
+		CCArray *objectArray;
+
+		{
+			PM_TRACE_ZONE(create_zone, "createObjectsFromString");
 
-			auto temp_array = layer->createObjectsFromString(new_data, false, false);
-			objectArray->addObjectsFromArray(temp_array);
+			objectArray = layer->createObjectsFromString(level_string, false, false);
 		}
 
+		auto time_created = std::chrono::steady_clock::now();
+
+		if (objectArray == nullptr) return;
+
+		// only after the objects exist, a failed stamp must not leave a structure behind
+		PMGlobal::currentStructures.insert(structure);
+
+		objectArray->retain();
+
 		// UndoObject *undo = createUndoObject(UndoCommand::New, false);
 		// undo->retain();
 		// undo->m_objects = objectArray;
@@ -2157,7 +3473,17 @@ class $modify(EditorUI) {
 		deselectAll();
 		selectObjects(objectArray, false);
 
-		PMGlobal::crearArrayWithoutCleanup(objectArray);
+		auto time_end = std::chrono::steady_clock::now();
+
+		using ms = std::chrono::duration<double, std::milli>;
+
+		log::info("clickOnPosition: stamped {} objects in {:.2f} ms (build {:.2f} ms; create {:.2f} ms; select {:.2f} ms)",
+			objectArray->count(),
+			ms(time_end - time_start).count(),
+			ms(time_built - time_start).count(),
+			ms(time_created - time_built).count(),
+			ms(time_end - time_created).count()
+		);
 
 		objectArray->release();
 	}
@@ -2193,4 +3519,23 @@ class $modify(EditorUI) {
 	// 	PMGlobal::triggerButtonActivation = false;
 	// 	PMGlobal::triggerButtonDisactivation = false;
 	// }
-};
\ No newline at end of file
+};
+
+// library writes are queued, everything has to be on disk before the editor or the game is left
+class $modify(EditorPauseLayer) {
+	void onExitEditor(CCObject *sender) {
+		PMGlobal::libraryWriter.flush();
+
+		EditorPauseLayer::onExitEditor(sender);
+	}
+	void onSaveAndExit(CCObject *sender) {
+		PMGlobal::libraryWriter.flush();
+
+		EditorPauseLayer::onSaveAndExit(sender);
+	}
+};
+
+$on_mod(DataSaved) {
+	PMGlobal::libraryWriter.stop();
+	PMGlobal::workerPool.stop();
+}
\ No newline at end of file